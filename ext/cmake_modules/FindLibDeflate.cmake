@@ -0,0 +1,33 @@
+# - Find libdeflate
+# Find the native libdeflate includes and library
+# This module defines
+#  LIBDEFLATE_INCLUDE_DIR, where to find libdeflate.h, etc.
+#  LIBDEFLATE_LIBRARIES, the libraries needed to use libdeflate.
+#  LIBDEFLATE_FOUND, If false, do not try to use libdeflate.
+# also defined, but not for general use are
+#  LIBDEFLATE_LIBRARY, where to find the libdeflate library.
+
+FIND_PATH(LIBDEFLATE_INCLUDE_DIR libdeflate.h
+/usr/local/include
+/usr/include
+)
+
+FIND_LIBRARY(LIBDEFLATE_LIBRARY
+  NAMES deflate libdeflate deflatestatic
+  PATHS /usr/lib64 /usr/lib /usr/local/lib
+  )
+
+IF (LIBDEFLATE_LIBRARY AND LIBDEFLATE_INCLUDE_DIR)
+  SET(LIBDEFLATE_LIBRARIES ${LIBDEFLATE_LIBRARY})
+  SET(LIBDEFLATE_FOUND TRUE)
+ELSE (LIBDEFLATE_LIBRARY AND LIBDEFLATE_INCLUDE_DIR)
+  SET(LIBDEFLATE_FOUND FALSE)
+  SET(LIBDEFLATE_INCLUDE_DIR "")
+  SET(LIBDEFLATE_LIBRARY "")
+ENDIF (LIBDEFLATE_LIBRARY AND LIBDEFLATE_INCLUDE_DIR)
+message("Found libdeflate: ${LIBDEFLATE_FOUND}")
+
+MARK_AS_ADVANCED(
+  LIBDEFLATE_LIBRARY
+  LIBDEFLATE_INCLUDE_DIR
+  )
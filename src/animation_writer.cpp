@@ -1,26 +1,30 @@
 #include "animation_writer.h"
 #include "logger.h"
 
+#include <algorithm>
+
 using namespace wotreplay;
 
 int animation_writer_t::update_model(const game_t &game, float window_start, float window_size, int packet_start) {
     int ix = packet_start;
     const auto &packets = game.get_packets();
-    std::map<int, std::tuple<float, float, float>> positions;
 
     float window_end = window_start + window_size;
 
     while (ix < packets.size() && packets[ix].clock() <= window_end) {
-        if (packets[ix].has_property(property_t::position)) {
-            positions[packets[ix].player_id()] = packets[ix].position();
-        }
-
         ix += 1;
     }
 
-    for (auto &it: positions) {
-        if (game.get_team_id(it.first) != -1) {
-            tracks[it.first].emplace_back(it.second);
+    // add the last position of each player in the window to its track
+    for (const trajectory_t &trajectory : game.get_trajectories().get_trajectories()) {
+        if (game.get_team_id(trajectory.player_id) == -1) {
+            continue;
+        }
+
+        auto begin = std::lower_bound(trajectory.packet_ix.begin(), trajectory.packet_ix.end(), static_cast<uint32_t>(packet_start));
+        auto end = std::lower_bound(begin, trajectory.packet_ix.end(), static_cast<uint32_t>(ix));
+        if (begin != end) {
+            tracks[trajectory.player_id].emplace_back(trajectory.position(end - trajectory.packet_ix.begin() - 1));
         }
     }
 
@@ -1,4 +1,6 @@
 #include "arena.h"
+#include "catalog.h"
+#include "logger.h"
 #include "regex.h"
 
 #include "tinyxml2.h"
@@ -7,8 +9,11 @@
 #include <boost/filesystem.hpp>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <sstream>
+#include <unordered_map>
 
 using namespace wotreplay;
 using namespace boost::filesystem;
@@ -133,7 +138,7 @@ static arena_t get_arena_definition(const boost::filesystem::path& path) {
 	return arena;
 }
 
-static std::map<std::string, arena_t> get_arena_definitions() {
+std::map<std::string, arena_t> wotreplay::read_arena_definitions() {
 	//xmlInitParser();
 	std::map<std::string, arena_t> arenas;
 	boost::filesystem::directory_iterator end_itr; // Default ctor yields past-the-end
@@ -152,56 +157,167 @@ static std::map<std::string, arena_t> get_arena_definitions() {
 }
 
 
-static std::map<std::string, arena_t> arenas;
-static bool is_arenas_initalized = false;
+/** names used by older replays for arenas which share their short name with another arena */
+static const std::unordered_map<std::string, std::string> legacy_names = {
+	{ "north_america", "44_north_america" }
+};
+
+namespace {
+	/**
+	 * The loaded arena definitions, a catalog is immutable once it is published. An update copies the
+	 * catalog and publishes the copy, readers keep using the catalog they loaded.
+	 */
+	struct arena_catalog_t {
+		/** arenas by their name */
+		arena_map_t arenas;
+		/** arenas by their name without the numeric prefix (e.g. karelia for 01_karelia) */
+		std::unordered_map<std::string, std::shared_ptr<const arena_t>> aliases;
+		/** indicates all arena definitions are loaded */
+		bool complete = false;
+	};
+}
+
+/** the published catalog, only accessed with std::atomic_load and std::atomic_store */
+static std::shared_ptr<const arena_catalog_t> arena_catalog = std::make_shared<const arena_catalog_t>();
+/** serializes the updates of arena_catalog */
+static std::mutex arena_catalog_mutex;
+
+/**
+ * Get the name of an arena without its numeric prefix.
+ * @return the short name, empty if the name has no numeric prefix
+ */
+static std::string get_short_name(const std::string &name) {
+	size_t pos = name.find_first_not_of("0123456789");
+	if (pos == 0 || pos == std::string::npos || name[pos] != '_') {
+		return std::string();
+	}
+
+	return name.substr(pos + 1);
+}
+
+/**
+ * Add an arena to the arenas and the alias index, an arena which is already present is kept.
+ */
+static void add_arena(arena_catalog_t &catalog, arena_t arena) {
+	std::string name = arena.name;
+	if (catalog.arenas.count(name) > 0) {
+		return;
+	}
+
+	auto entry = std::make_shared<const arena_t>(std::move(arena));
+	catalog.arenas[name] = entry;
+
+	std::string short_name = get_short_name(name);
+	if (!short_name.empty()) {
+		catalog.aliases[short_name] = entry;
+	}
+}
+
+/**
+ * Add arenas in order of their name, when arenas share a short name it refers to the last one.
+ */
+static void add_arenas(arena_catalog_t &catalog, std::map<std::string, arena_t> definitions) {
+	for (auto &definition : definitions) {
+		add_arena(catalog, std::move(definition.second));
+	}
+}
+
+/**
+ * Load the arenas from the catalog file, the arenas which are already loaded are kept.
+ * @return \c true if the catalog file was read
+ */
+static bool load_arena_catalog(arena_catalog_t &catalog) {
+	std::map<std::string, arena_t> catalog_arenas;
+	if (!read_catalog(catalog_path, &catalog_arenas, nullptr)) {
+		return false;
+	}
+
+	add_arenas(catalog, std::move(catalog_arenas));
+	return true;
+}
 
 void wotreplay::init_arena_definition() {
-	if (!is_arenas_initalized) {
-		arenas = get_arena_definitions();
-		is_arenas_initalized = true;
+	if (std::atomic_load(&arena_catalog)->complete) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(arena_catalog_mutex);
+	auto catalog = std::atomic_load(&arena_catalog);
+	if (catalog->complete) {
+		return;
 	}
+
+	auto updated = std::make_shared<arena_catalog_t>(*catalog);
+	// the xml definitions are only parsed when there is no catalog file
+	if (!load_arena_catalog(*updated)) {
+		logger.writef(log_level_t::debug, "No catalog found (%1%), reading the arena definitions\n", catalog_path);
+		add_arenas(*updated, read_arena_definitions());
+	}
+	updated->complete = true;
+
+	std::atomic_store(&arena_catalog, std::shared_ptr<const arena_catalog_t>(std::move(updated)));
 }
 
-const std::map<std::string, arena_t>& wotreplay::get_arenas() {
-	return arenas;
+std::shared_ptr<const arena_map_t> wotreplay::get_arenas() {
+	auto catalog = std::atomic_load(&arena_catalog);
+	return std::shared_ptr<const arena_map_t>(catalog, &catalog->arenas);
 }
 
-bool wotreplay::get_arena(const std::string & name, arena_t & arena, bool force) {
-	bool has_result = false;
-	auto it = arenas.find(name);
+/**
+ * Find an arena by its name, its legacy name or its short name.
+ */
+static std::shared_ptr<const arena_t> find_arena(const arena_catalog_t &catalog, const std::string &name) {
+	auto it = catalog.arenas.find(name);
+	if (it != catalog.arenas.end()) {
+		return it->second;
+	}
+
+	auto legacy_name = legacy_names.find(name);
+	if (legacy_name != legacy_names.end() && (it = catalog.arenas.find(legacy_name->second)) != catalog.arenas.end()) {
+		return it->second;
+	}
 
-	if (it == arenas.end()) {
-		if (name == "north_america") {
-			arena = arenas["44_north_america"];
-			has_result = true;
-		}
-		else {
-			for (auto entry : arenas) {
-				std::string map_name = entry.first;
-				std::string short_map_name(map_name.begin() + 3, map_name.end());
-				if (short_map_name == name) {
-					// rewrite map name
-					arena = entry.second;
-					has_result = true;
-				}
-			}
-		}
+	auto alias = catalog.aliases.find(name);
+	return alias != catalog.aliases.end() ? alias->second : nullptr;
+}
+
+std::shared_ptr<const arena_t> wotreplay::get_arena(const std::string &name, bool force) {
+	std::shared_ptr<const arena_t> arena = find_arena(*std::atomic_load(&arena_catalog), name);
+	if (arena || !force) {
+		return arena;
 	}
-	else {
-		arena = arenas[name];
-		has_result = true;
+
+	// the arena may have been loaded by another thread while waiting for the lock
+	std::lock_guard<std::mutex> lock(arena_catalog_mutex);
+	auto catalog = std::atomic_load(&arena_catalog);
+	arena = find_arena(*catalog, name);
+	if (arena) {
+		return arena;
+	}
+
+	auto updated = std::make_shared<arena_catalog_t>(*catalog);
+	bool modified = false;
+
+	if (!updated->complete) {
+		// all definitions are available in the catalog file, the arena is only read from its xml file without it
+		updated->complete = modified = load_arena_catalog(*updated);
+		arena = find_arena(*updated, name);
 	}
 
-	if (!has_result && force) {
-		//xmlInitParser();
+	if (!arena) {
+		auto legacy_name = legacy_names.find(name);
 		path path("maps/definitions");
-		path /= name + ".xml";
+		path /= (legacy_name != legacy_names.end() ? legacy_name->second : name) + ".xml";
 		if (is_regular_file(path)) {
-			arena = arenas[name] = get_arena_definition(path);
-			has_result = true;
+			add_arena(*updated, get_arena_definition(path));
+			arena = find_arena(*updated, name);
+			modified = true;
 		}
-		//xmlCleanupParser();
 	}
 
-	return has_result;
-}
\ No newline at end of file
+	if (modified) {
+		std::atomic_store(&arena_catalog, std::shared_ptr<const arena_catalog_t>(std::move(updated)));
+	}
+
+	return arena;
+}
@@ -10,6 +10,7 @@
 #define wotreplay_arena_def_h
 
 #include <map>
+#include <memory>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -59,24 +60,35 @@ namespace wotreplay {
     };
 
     /**
-     * Find the arena definition for the arena name
+     * Find the arena definition for the arena name, the name is either the full name of the arena
+     * (e.g. 01_karelia), its name without the numeric prefix (karelia) or a legacy name
      * @param name the arena name
-     * @param arena output variable to store the arena
-     * @param when definition is not found in cache, force lookup on disk
-     * @return \c true if the arena was found \c false if not
+     * @param force when definition is not found in cache, force lookup on disk, the definitions
+     * are safe to use from multiple threads
+     * @return the arena, \c nullptr if the arena was not found
      */
-    bool get_arena(const std::string &name, arena_t &arena, bool force);
+    std::shared_ptr<const arena_t> get_arena(const std::string &name, bool force);
+
+    /** arena definitions by their name */
+    typedef std::map<std::string, std::shared_ptr<const arena_t>> arena_map_t;
 
     /**
-     * Get the complete list of available arena definitions
+     * Get the complete list of available arena definitions, the list is not affected by arenas
+     * which are loaded later on
      * @return arena definition map
      */
-    const std::map<std::string, arena_t> &get_arenas();
+    std::shared_ptr<const arena_map_t> get_arenas();
 
     /**
      * Init arena defintion.
      */
     void init_arena_definition();
+
+    /**
+     * Read all arena definitions from the xml files in maps/definitions, without using the catalog
+     * @return arena definition map
+     */
+    std::map<std::string, arena_t> read_arena_definitions();
 }
 
 #endif /* defined(wotreplay_arena_def_h) */
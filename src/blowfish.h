@@ -0,0 +1,47 @@
+#ifndef wotreplay_blowfish_h
+#define wotreplay_blowfish_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @file */
+
+namespace wotreplay {
+    /**
+     * Built-in implementation of the Blowfish block cipher, supporting ECB decryption. Independent
+     * blocks are decrypted in interleaved lanes to hide the latency of the S-box lookups.
+     */
+    class blowfish_t {
+    public:
+        /** block size of the cipher in bytes */
+        static const size_t block_size = 8;
+        /**
+         * Create a cipher with the given key
+         * @param key_data the key
+         * @param key_size the key size in bytes (at most 56)
+         */
+        blowfish_t(const unsigned char *key_data, int key_size);
+        /**
+         * Decrypt a sequence of blocks in ECB mode, in and out may refer to the same buffer.
+         * @param out output buffer
+         * @param in input buffer
+         * @param len number of bytes to decrypt, should be a multiple of the block size
+         */
+        void decrypt_ecb(unsigned char *out, const unsigned char *in, size_t len) const;
+    private:
+        /**
+         * Encrypt a single block, used to derive the subkeys
+         * @param l left half of the block
+         * @param r right half of the block
+         */
+        void encrypt(uint32_t &l, uint32_t &r) const;
+        /** the Blowfish round function */
+        uint32_t f(uint32_t x) const;
+        /** subkeys */
+        uint32_t p[18];
+        /** substitution boxes */
+        uint32_t s[4][256];
+    };
+}
+
+#endif /* defined(wotreplay_blowfish_h) */
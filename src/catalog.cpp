@@ -0,0 +1,298 @@
+#include "catalog.h"
+#include "logger.h"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdint.h>
+
+using namespace wotreplay;
+
+const char * const wotreplay::catalog_path = "catalog.bin";
+
+static const char catalog_magic[] = "WOTCAT02";
+static const size_t catalog_magic_size = sizeof(catalog_magic) - 1;
+
+namespace {
+    /** identifies the xml definitions a catalog is compiled from */
+    struct definitions_stamp_t {
+        /** number of arena definitions */
+        uint32_t arena_count;
+        /** newest modification time of the arena definitions and tanks.xml */
+        int64_t last_write_time;
+    };
+}
+
+/** @return The stamp of the xml definitions, relative to the root */
+static definitions_stamp_t get_definitions_stamp() {
+    definitions_stamp_t stamp = { 0, 0 };
+    boost::system::error_code ec;
+
+    boost::filesystem::directory_iterator end_itr;
+    for (boost::filesystem::directory_iterator it("maps/definitions", ec); !ec && it != end_itr; it.increment(ec)) {
+        if (!boost::filesystem::is_regular_file(it->status()) || it->path().extension() != ".xml") {
+            continue;
+        }
+
+        stamp.arena_count += 1;
+        std::time_t time = boost::filesystem::last_write_time(it->path(), ec);
+        stamp.last_write_time = std::max<int64_t>(stamp.last_write_time, ec ? 0 : time);
+        ec.clear();
+    }
+
+    std::time_t time = boost::filesystem::last_write_time("tanks.xml", ec);
+    stamp.last_write_time = std::max<int64_t>(stamp.last_write_time, ec ? 0 : time);
+    return stamp;
+}
+
+template <typename T>
+static void write_value(std::ostream &os, const T &value) {
+    os.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void write_string(std::ostream &os, const std::string &value) {
+    write_value(os, static_cast<uint32_t>(value.size()));
+    os.write(value.data(), value.size());
+}
+
+static void write_point(std::ostream &os, const std::tuple<float, float> &point) {
+    write_value(os, std::get<0>(point));
+    write_value(os, std::get<1>(point));
+}
+
+static void write_team_positions(std::ostream &os, const std::map<int, std::vector<std::tuple<float, float>>> &positions) {
+    write_value(os, static_cast<uint32_t>(positions.size()));
+    for (const auto &team_positions : positions) {
+        write_value(os, static_cast<int32_t>(team_positions.first));
+        write_value(os, static_cast<uint32_t>(team_positions.second.size()));
+        for (const auto &position : team_positions.second) {
+            write_point(os, position);
+        }
+    }
+}
+
+void wotreplay::write_catalog(const boost::filesystem::path &path, const std::map<std::string, arena_t> &arenas,
+                              const std::map<std::string, tank_t> &tanks) {
+    // the arenas are written first to determine the size of their section
+    std::ostringstream arena_section(std::ios::binary);
+    write_value(arena_section, static_cast<uint32_t>(arenas.size()));
+    for (const auto &entry : arenas) {
+        const arena_t &arena = entry.second;
+        write_string(arena_section, arena.name);
+        write_string(arena_section, arena.mini_map);
+        write_point(arena_section, arena.bounding_box.bottom_left);
+        write_point(arena_section, arena.bounding_box.upper_right);
+        write_value(arena_section, static_cast<uint32_t>(arena.configurations.size()));
+        for (const auto &configuration_entry : arena.configurations) {
+            const arena_configuration_t &configuration = configuration_entry.second;
+            write_string(arena_section, configuration.mode);
+            write_point(arena_section, configuration.control_point);
+            write_team_positions(arena_section, configuration.team_spawn_points);
+            write_team_positions(arena_section, configuration.team_base_positions);
+        }
+    }
+
+    definitions_stamp_t stamp = get_definitions_stamp();
+
+    std::ofstream os(path.string(), std::ios::binary);
+    os.write(catalog_magic, catalog_magic_size);
+    write_value(os, stamp.arena_count);
+    write_value(os, stamp.last_write_time);
+    write_string(os, arena_section.str());
+
+    write_value(os, static_cast<uint32_t>(tanks.size()));
+    for (const auto &entry : tanks) {
+        const tank_t &tank = entry.second;
+        write_value(os, static_cast<int32_t>(tank.country_id));
+        write_string(os, tank.country_name);
+        write_value(os, static_cast<int32_t>(tank.tank_id));
+        write_string(os, tank.name);
+        write_value(os, static_cast<int32_t>(tank.comp_desc));
+        write_string(os, tank.icon);
+        write_value(os, static_cast<int32_t>(tank.class_id));
+        write_string(os, tank.class_name);
+        write_value(os, static_cast<int32_t>(tank.tier));
+        write_value(os, static_cast<int32_t>(tank.active));
+    }
+
+    if (!os) {
+        throw std::runtime_error("Failed to write catalog: " + path.string());
+    }
+}
+
+namespace {
+    /** reads the values of a catalog from a mapped region, a read past the end invalidates the reader */
+    class catalog_reader_t {
+    public:
+        catalog_reader_t(const uint8_t *begin, const uint8_t *end)
+            : pos(begin), end(end), valid(true)
+        {}
+
+        template <typename T>
+        T read() {
+            T value = T();
+            if (static_cast<size_t>(end - pos) < sizeof(value)) {
+                valid = false;
+                return value;
+            }
+
+            std::memcpy(&value, pos, sizeof(value));
+            pos += sizeof(value);
+            return value;
+        }
+
+        std::string read_string() {
+            uint32_t size = read<uint32_t>();
+            if (static_cast<size_t>(end - pos) < size) {
+                valid = false;
+                return std::string();
+            }
+
+            std::string value(reinterpret_cast<const char*>(pos), size);
+            pos += size;
+            return value;
+        }
+
+        std::tuple<float, float> read_point() {
+            float x = read<float>();
+            float y = read<float>();
+            return std::make_tuple(x, y);
+        }
+
+        std::map<int, std::vector<std::tuple<float, float>>> read_team_positions() {
+            std::map<int, std::vector<std::tuple<float, float>>> positions;
+            uint32_t team_count = read<uint32_t>();
+            for (uint32_t ix = 0; valid && ix < team_count; ++ix) {
+                auto &team_positions = positions[read<int32_t>()];
+                uint32_t count = read<uint32_t>();
+                for (uint32_t jx = 0; valid && jx < count; ++jx) {
+                    team_positions.push_back(read_point());
+                }
+            }
+            return positions;
+        }
+
+        void skip(size_t size) {
+            if (static_cast<size_t>(end - pos) < size) {
+                valid = false;
+                return;
+            }
+
+            pos += size;
+        }
+
+        bool is_valid() const {
+            return valid;
+        }
+    private:
+        const uint8_t *pos;
+        const uint8_t *end;
+        bool valid;
+    };
+}
+
+bool wotreplay::read_catalog(const boost::filesystem::path &path, std::map<std::string, arena_t> *arenas,
+                             std::map<std::string, tank_t> *tanks) {
+    boost::system::error_code ec;
+    if (!boost::filesystem::is_regular_file(path, ec) ||
+        boost::filesystem::file_size(path, ec) < catalog_magic_size || ec) {
+        return false;
+    }
+
+    std::unique_ptr<boost::interprocess::mapped_region> region;
+    try {
+        boost::interprocess::file_mapping mapping(path.string().c_str(), boost::interprocess::read_only);
+        region.reset(new boost::interprocess::mapped_region(mapping, boost::interprocess::read_only));
+    }
+    catch (std::exception &e) {
+        logger.writef(log_level_t::warning, "Failed to read catalog (%1%): %2%\n", path.string(), e.what());
+        return false;
+    }
+
+    const uint8_t *begin = static_cast<const uint8_t*>(region->get_address());
+    const uint8_t *end = begin + region->get_size();
+    if (std::memcmp(begin, catalog_magic, catalog_magic_size) != 0) {
+        logger.writef(log_level_t::warning, "Invalid catalog: %1%\n", path.string());
+        return false;
+    }
+
+    catalog_reader_t reader(begin + catalog_magic_size, end);
+    definitions_stamp_t catalog_stamp;
+    catalog_stamp.arena_count = reader.read<uint32_t>();
+    catalog_stamp.last_write_time = reader.read<int64_t>();
+
+    // without xml definitions, e.g. when only the catalog is installed, the catalog is used as is
+    definitions_stamp_t stamp = get_definitions_stamp();
+    if ((stamp.arena_count > 0 || stamp.last_write_time > 0) &&
+        (stamp.arena_count != catalog_stamp.arena_count || stamp.last_write_time != catalog_stamp.last_write_time)) {
+        logger.writef(log_level_t::warning, "Catalog is out of date, ignoring it: %1%\n", path.string());
+        return false;
+    }
+
+    uint32_t arena_section_size = reader.read<uint32_t>();
+    if (arenas == nullptr) {
+        reader.skip(arena_section_size);
+    }
+
+    std::map<std::string, arena_t> catalog_arenas;
+    uint32_t arena_count = arenas != nullptr ? reader.read<uint32_t>() : 0;
+    for (uint32_t ix = 0; reader.is_valid() && ix < arena_count; ++ix) {
+        arena_t arena;
+        arena.name = reader.read_string();
+        arena.mini_map = reader.read_string();
+        arena.bounding_box.bottom_left = reader.read_point();
+        arena.bounding_box.upper_right = reader.read_point();
+
+        uint32_t configuration_count = reader.read<uint32_t>();
+        for (uint32_t jx = 0; reader.is_valid() && jx < configuration_count; ++jx) {
+            arena_configuration_t configuration;
+            configuration.mode = reader.read_string();
+            configuration.control_point = reader.read_point();
+            configuration.team_spawn_points = reader.read_team_positions();
+            configuration.team_base_positions = reader.read_team_positions();
+            arena.configurations[configuration.mode] = std::move(configuration);
+        }
+
+        std::string name = arena.name;
+        catalog_arenas[name] = std::move(arena);
+    }
+
+    std::map<std::string, tank_t> catalog_tanks;
+    uint32_t tank_count = tanks != nullptr ? reader.read<uint32_t>() : 0;
+    for (uint32_t ix = 0; reader.is_valid() && ix < tank_count; ++ix) {
+        tank_t tank;
+        tank.country_id = reader.read<int32_t>();
+        tank.country_name = reader.read_string();
+        tank.tank_id = reader.read<int32_t>();
+        tank.name = reader.read_string();
+        tank.comp_desc = reader.read<int32_t>();
+        tank.icon = reader.read_string();
+        tank.class_id = reader.read<int32_t>();
+        tank.class_name = reader.read_string();
+        tank.tier = reader.read<int32_t>();
+        tank.active = reader.read<int32_t>();
+
+        std::string icon = tank.icon;
+        catalog_tanks[icon] = std::move(tank);
+    }
+
+    if (!reader.is_valid()) {
+        logger.writef(log_level_t::warning, "Invalid catalog: %1%\n", path.string());
+        return false;
+    }
+
+    if (arenas != nullptr) {
+        arenas->swap(catalog_arenas);
+    }
+
+    if (tanks != nullptr) {
+        tanks->swap(catalog_tanks);
+    }
+
+    return true;
+}
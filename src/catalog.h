@@ -0,0 +1,49 @@
+#ifndef wotreplay_catalog_h
+#define wotreplay_catalog_h
+
+#include "arena.h"
+#include "tank.h"
+
+#include <boost/filesystem.hpp>
+#include <map>
+#include <string>
+
+/** @file */
+
+namespace wotreplay {
+    /** path of the catalog, relative to the root */
+    extern const char * const catalog_path;
+
+    /**
+     * Write the arena and tank definitions to a binary catalog, so they can be loaded without parsing
+     * the xml definitions. The catalog is created by the mode --create-catalog, see the Makefile in data.
+     * Layout, all integers are uint32_t and strings are prefixed by their size:
+     *
+     * - magic "WOTCAT02" (8 bytes)
+     * - number of arena definitions and the newest modification time (int64_t) of the arena definitions
+     *   and tanks.xml, a catalog which does not match the xml definitions is out of date
+     * - size of the arena section, followed by the arena section: number of arenas, followed by each arena:
+     *   name, mini map, bounding box (4 floats), number of configurations, followed by each configuration:
+     *   mode, control point (2 floats), spawn points and base positions (number of teams, followed by the
+     *   team id, number of positions and the positions)
+     * - number of tanks, followed by each tank: the members of tank_t in order of declaration
+     *
+     * @param path The path of the catalog
+     * @param arenas The arena definitions
+     * @param tanks The tank definitions
+     */
+    void write_catalog(const boost::filesystem::path &path, const std::map<std::string, arena_t> &arenas,
+                       const std::map<std::string, tank_t> &tanks);
+
+    /**
+     * Read the arena and/or tank definitions from a catalog written by write_catalog.
+     * @param path The path of the catalog
+     * @param arenas Output variable receiving the arena definitions, skipped if \c nullptr
+     * @param tanks Output variable receiving the tank definitions, skipped if \c nullptr
+     * @return \c true if the catalog was read, \c false if it is missing, invalid or out of date
+     */
+    bool read_catalog(const boost::filesystem::path &path, std::map<std::string, arena_t> *arenas,
+                      std::map<std::string, tank_t> *tanks);
+}
+
+#endif /* defined(wotreplay_catalog_h) */
@@ -0,0 +1,74 @@
+#include "chunk_ring.h"
+
+#include <thread>
+
+using namespace wotreplay;
+
+/** number of times a waiting thread yields before it blocks */
+const int spin_count = 64;
+
+chunk_ring_t::chunk_ring_t(size_t capacity, size_t chunk_size)
+    : chunks(capacity), head(0), tail(0), closed(false), waiters(0)
+{
+    for (chunk_t &chunk : chunks) {
+        chunk.data.resize(chunk_size);
+        chunk.size = 0;
+    }
+}
+
+chunk_t *chunk_ring_t::acquire_write() {
+    size_t pos = tail.load(std::memory_order_relaxed);
+    wait([&] {
+        return closed.load() || pos - head.load() != chunks.size();
+    });
+
+    return closed.load() ? nullptr : &chunks[pos % chunks.size()];
+}
+
+void chunk_ring_t::commit_write() {
+    tail.store(tail.load(std::memory_order_relaxed) + 1);
+    notify();
+}
+
+chunk_t *chunk_ring_t::acquire_read() {
+    size_t pos = head.load(std::memory_order_relaxed);
+    wait([&] {
+        return closed.load() || pos != tail.load();
+    });
+
+    // the producer may have committed a chunk just before closing the ring
+    return pos == tail.load() ? nullptr : &chunks[pos % chunks.size()];
+}
+
+void chunk_ring_t::commit_read() {
+    head.store(head.load(std::memory_order_relaxed) + 1);
+    notify();
+}
+
+void chunk_ring_t::close() {
+    closed.store(true);
+    notify();
+}
+
+void chunk_ring_t::wait(const std::function<bool()> &ready) {
+    for (int i = 0; i < spin_count; ++i) {
+        if (ready()) {
+            return;
+        }
+        std::this_thread::yield();
+    }
+
+    // the waiter is registered before the last check of the condition, a change made after this check
+    // sees the waiter and takes the mutex to notify
+    std::unique_lock<std::mutex> lock(mutex);
+    ++waiters;
+    condition.wait(lock, ready);
+    --waiters;
+}
+
+void chunk_ring_t::notify() {
+    if (waiters.load() > 0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        condition.notify_all();
+    }
+}
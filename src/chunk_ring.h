@@ -0,0 +1,78 @@
+#ifndef wotreplay_chunk_ring_h
+#define wotreplay_chunk_ring_h
+
+#include "types.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <stddef.h>
+#include <vector>
+
+/** @file */
+
+namespace wotreplay {
+    /** A chunk of data passed through a wotreplay::chunk_ring_t */
+    struct chunk_t {
+        /** buffer of the chunk, allocated once by the ring */
+        buffer_t data;
+        /** number of bytes of data in use */
+        size_t size;
+    };
+
+    /**
+     * wotreplay::chunk_ring_t is a bounded ring of chunks between a single producer thread and a single
+     * consumer thread. The chunks are allocated once, a producer fills a free chunk in place and a consumer
+     * hands it back after use. Passing chunks is lock-free, a thread waiting for a free or filled chunk
+     * yields for a short while and then blocks until the other side commits a chunk or closes the ring.
+     */
+    class chunk_ring_t {
+    public:
+        /**
+         * Create a ring.
+         * @param capacity number of chunks in the ring
+         * @param chunk_size size of the buffer of each chunk
+         */
+        chunk_ring_t(size_t capacity, size_t chunk_size);
+        chunk_ring_t(const chunk_ring_t&) = delete;
+        chunk_ring_t &operator=(const chunk_ring_t&) = delete;
+        /**
+         * Wait for a free chunk, called by the producer.
+         * @return The chunk to fill, or \c nullptr if the ring is closed
+         */
+        chunk_t *acquire_write();
+        /** Pass the chunk returned by acquire_write() to the consumer. */
+        void commit_write();
+        /**
+         * Wait for a filled chunk, called by the consumer.
+         * @return The next chunk, or \c nullptr if the ring is closed and all chunks are consumed
+         */
+        chunk_t *acquire_read();
+        /** Return the chunk returned by acquire_read() to the producer. */
+        void commit_read();
+        /**
+         * Close the ring, called by the producer after the last chunk or by the consumer to stop the producer.
+         */
+        void close();
+    private:
+        /** Wait until \c ready returns \c true, spinning first and then blocking on the condition. */
+        void wait(const std::function<bool()> &ready);
+        /** Wake up a blocked thread after a change of the ring. */
+        void notify();
+
+        std::vector<chunk_t> chunks;
+        /** number of chunks consumed, only written by the consumer */
+        std::atomic<size_t> head;
+        /** number of chunks produced, only written by the producer */
+        std::atomic<size_t> tail;
+        /** indicates no more chunks are produced */
+        std::atomic<bool> closed;
+        /** number of threads blocked in wait() */
+        std::atomic<int> waiters;
+        std::mutex mutex;
+        std::condition_variable condition;
+    };
+}
+
+#endif /* defined(wotreplay_chunk_ring_h) */
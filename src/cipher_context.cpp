@@ -1,5 +1,7 @@
 #include <openssl/opensslv.h>
 #include <openssl/err.h>
+#include <cstring>
+#include <stdexcept>
 #include <string>
 
 #include "cipher_context.h"
@@ -8,7 +10,8 @@ CipherContext::CipherContext(
         const char* cipher_name,
         const unsigned char* key_data,
         int key_size,
-        const unsigned char* iv
+        const unsigned char* iv,
+        cipher_backend_t backend
     ) :
 #if OPENSSL_VERSION_MAJOR >= 3
         legacy_provider(nullptr),
@@ -18,6 +21,14 @@ CipherContext::CipherContext(
         cipher(nullptr),
         ctx(nullptr)
 {
+    if (backend == cipher_backend_t::builtin) {
+        // the built-in backend needs no OpenSSL state at all
+        if (std::strcmp(cipher_name, "BF-ECB") != 0) {
+            throw std::runtime_error(std::string("Cipher not supported by built-in backend: ") + cipher_name);
+        }
+        blowfish.reset(new wotreplay::blowfish_t(key_data, key_size));
+        return;
+    }
 
 #if OPENSSL_VERSION_MAJOR >= 3
     OPENSSL_assert(ossl_ctx = OSSL_LIB_CTX_new());
@@ -37,18 +48,35 @@ CipherContext::CipherContext(
 }
 
 int CipherContext::update(unsigned char* out, int* out_len, const unsigned char* in, int in_len) {
+    if (blowfish) {
+        // no padding, only complete blocks are expected
+        OPENSSL_assert(in_len % wotreplay::blowfish_t::block_size == 0);
+        blowfish->decrypt_ecb(out, in, in_len);
+        *out_len = in_len;
+        return 1;
+    }
+
     int result = EVP_CipherUpdate(ctx, out, out_len, in, in_len) == 1;
     OPENSSL_assert(result);
     return result;
 }
 
 int CipherContext::finalize(unsigned char *out, int* out_len) {
+    if (blowfish) {
+        *out_len = 0;
+        return 1;
+    }
+
     int result = EVP_CipherFinal_ex(ctx, out, out_len) == 1;
     OPENSSL_assert(result);
     return result;
 }
 
 CipherContext::~CipherContext() {
+    if (blowfish) {
+        return;
+    }
+
     // show errors for debugging
     ERR_print_errors_fp(stderr);
 
@@ -11,9 +11,24 @@
 
 #include <openssl/evp.h>
 
+#include <memory>
+
+#include "blowfish.h"
+
+/**
+ * Implementations available to CipherContext
+ */
+enum class cipher_backend_t {
+    /** OpenSSL EVP interface, requires the legacy provider for Blowfish on OpenSSL 3 */
+    openssl,
+    /** built-in implementation, only supports BF-ECB decryption */
+    builtin
+};
+
 class CipherContext {
 public:
-    CipherContext(const char* cipher_name, const unsigned char* key_data, int key_size, const unsigned char* iv);
+    CipherContext(const char* cipher_name, const unsigned char* key_data, int key_size, const unsigned char* iv,
+                  cipher_backend_t backend = cipher_backend_t::openssl);
     int update(unsigned char* out, int* out_len, const unsigned char* in, int in_len);
     int finalize(unsigned char* out, int* out_len);
     ~CipherContext();
@@ -27,7 +42,7 @@ private:
     const EVP_CIPHER *cipher;
 #endif
     EVP_CIPHER_CTX *ctx;
+    std::unique_ptr<wotreplay::blowfish_t> blowfish;
 };
 
 #endif
-
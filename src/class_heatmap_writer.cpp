@@ -10,6 +10,7 @@ using boost::algorithm::clamp;
 void class_heatmap_writer_t::set_draw_rules(const std::vector<draw_rule_t> &rules)
 {
     this->rules = rules;
+    this->program = rule_program_t(rules);
 }
 
 const std::vector<draw_rule_t> &class_heatmap_writer_t::get_draw_rules() const {
@@ -37,9 +38,19 @@ void class_heatmap_writer_t::init(const wotreplay::arena_t &arena, const std::st
     initialized = true;
 }
 
+void class_heatmap_writer_t::begin(const game_t &game) {
+    heatmap_writer_t::begin(game);
+    program.bind(game);
+}
+
 int class_heatmap_writer_t::get_class(const game_t &game, const packet_t &packet) const {
-    virtual_machine_t vm(game, rules);
-    int rule_id = vm(packet);
+    int rule_id;
+    if (program.is_bound(game)) {
+        rule_id = program(game, packet);
+    } else {
+        virtual_machine_t vm(game, rules);
+        rule_id = vm(packet);
+    }
     return rule_id < 0 ? -1 : classes.at(rules[rule_id].color);
 }
 
@@ -22,10 +22,13 @@ namespace wotreplay {
          * @return current drawing rules
          */
         virtual const std::vector<draw_rule_t> &get_draw_rules() const;
+        virtual void begin(const game_t &game) override;
         virtual int get_class(const game_t &game, const packet_t &packet) const override;
         virtual void finish() override;
     protected:
         std::vector<draw_rule_t> rules;
+        /** the rules compiled for evaluating the packets of the game passed to begin() */
+        rule_program_t program;
         std::map<uint32_t, int> classes;
     };
 }
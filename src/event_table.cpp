@@ -0,0 +1,117 @@
+#include "event_table.h"
+#include "game.h"
+#include "packet_cursor.h"
+#include "packet_visitor.h"
+
+#include <unordered_map>
+
+using namespace wotreplay;
+
+class event_table_t::event_visitor_t : public packet_visitor_t<event_visitor_t> {
+public:
+    event_visitor_t(event_table_t &events)
+        : events(events)
+    {}
+
+    void on_health(const game_t &game, const packet_t &packet, const health_event_t &event) {
+        auto last = last_health.find(event.player_id);
+        int32_t delta = last == last_health.end() ? 0 : static_cast<int32_t>(last->second) - event.health;
+        last_health[event.player_id] = event.health;
+
+        health_update_t update = { event.clock, event.player_id, event.source, event.health, delta };
+        events.health_updates.push_back(update);
+    }
+
+    void on_module_damage(const game_t &game, const packet_t &packet, const module_damage_event_t &event) {
+        module_damage_t damage = { event.clock, event.player_id, event.source, event.target };
+        events.module_damage.push_back(damage);
+    }
+
+    void on_track_destroyed(const game_t &game, const packet_t &packet, const track_destroyed_event_t &event) {
+        if (event.track_id != 0) {
+            track_break_t track_break = { event.clock, event.player_id, event.track_id };
+            events.track_breaks.push_back(track_break);
+        }
+    }
+
+    void on_message(const game_t &game, const packet_t &packet, const message_event_t &event) {
+        chat_message_t message = { event.clock, event.message };
+        events.chat_messages.push_back(message);
+    }
+
+    void on_tank_destroyed(const game_t &game, const packet_t &packet, const tank_destroyed_event_t &event) {
+        kill_t kill;
+        kill.clock = event.clock;
+        kill.victim = event.target;
+        kill.killer = event.destroyed_by;
+        kill.cause = event.type;
+        kill.has_victim_position = find_position(game, event.target, event.clock, kill.victim_position);
+        kill.has_killer_position = find_position(game, event.destroyed_by, event.clock, kill.killer_position);
+        events.kills.push_back(kill);
+    }
+private:
+    static bool find_position(const game_t &game, uint32_t player_id, float clock, std::tuple<float, float, float> &position) {
+        const trajectory_t *trajectory = game.get_trajectories().find(player_id);
+        size_t ix;
+        if (trajectory == nullptr || !trajectory->find(clock, ix)) {
+            return false;
+        }
+        position = trajectory->position(ix);
+        return true;
+    }
+
+    event_table_t &events;
+    /** last known health of each player */
+    std::unordered_map<uint32_t, uint16_t> last_health;
+};
+
+void event_table_t::build(const game_t &game) {
+    clear();
+
+    event_visitor_t visitor(*this);
+    packet_cursor_t cursor(game, { 0x07, 0x08, 0x23 });
+    while (cursor.next()) {
+        visitor.visit(game, cursor.packet());
+    }
+
+    kills.shrink_to_fit();
+    health_updates.shrink_to_fit();
+    module_damage.shrink_to_fit();
+    track_breaks.shrink_to_fit();
+    chat_messages.shrink_to_fit();
+
+    built = true;
+}
+
+void event_table_t::clear() {
+    kills.clear();
+    health_updates.clear();
+    module_damage.clear();
+    track_breaks.clear();
+    chat_messages.clear();
+    built = false;
+}
+
+bool event_table_t::is_built() const {
+    return built;
+}
+
+const std::vector<kill_t> &event_table_t::get_kills() const {
+    return kills;
+}
+
+const std::vector<health_update_t> &event_table_t::get_health_updates() const {
+    return health_updates;
+}
+
+const std::vector<module_damage_t> &event_table_t::get_module_damage() const {
+    return module_damage;
+}
+
+const std::vector<track_break_t> &event_table_t::get_track_breaks() const {
+    return track_breaks;
+}
+
+const std::vector<chat_message_t> &event_table_t::get_chat_messages() const {
+    return chat_messages;
+}
@@ -0,0 +1,102 @@
+#ifndef wotreplay_event_table_h
+#define wotreplay_event_table_h
+
+#include <stdint.h>
+#include <string>
+#include <tuple>
+#include <vector>
+
+/** @file */
+
+namespace wotreplay {
+    class game_t;
+
+    /** A destroyed tank */
+    struct kill_t {
+        float clock;
+        uint32_t victim;
+        uint32_t killer;
+        /** 0: shell, 1: fire, 2: ram, 3: crash */
+        uint8_t cause;
+        /** \c true if victim_position is known */
+        bool has_victim_position;
+        /** position of the victim closest to the clock */
+        std::tuple<float, float, float> victim_position;
+        /** \c true if killer_position is known */
+        bool has_killer_position;
+        /** position of the killer closest to the clock */
+        std::tuple<float, float, float> killer_position;
+    };
+
+    /** A change of the health of a tank */
+    struct health_update_t {
+        float clock;
+        uint32_t player_id;
+        /** player causing the update, 0 if unknown */
+        uint32_t source;
+        uint16_t health;
+        /** health lost since the previous update of the player, 0 for the first update */
+        int32_t delta;
+    };
+
+    /** Damage to a module of a tank */
+    struct module_damage_t {
+        float clock;
+        uint32_t player_id;
+        uint32_t source;
+        uint32_t target;
+    };
+
+    /** A destroyed track */
+    struct track_break_t {
+        float clock;
+        uint32_t player_id;
+        /** 0x1D for the left track, 0x1E for the right track */
+        uint8_t track_id;
+    };
+
+    /** A message in the battle log */
+    struct chat_message_t {
+        float clock;
+        std::string message;
+    };
+
+    /**
+     * wotreplay::event_table_t contains the events of a game, extracted from the packets in one pass.
+     * The events are stored in the order of the packets.
+     */
+    class event_table_t {
+    public:
+        /**
+         * Extract the events from the packets of a game, replacing the current content.
+         * @param game The game
+         */
+        void build(const game_t &game);
+        /**
+         * Removes all events.
+         */
+        void clear();
+        /** @return \c true if build() was called after the last clear() */
+        bool is_built() const;
+        /** @return The destroyed tanks */
+        const std::vector<kill_t> &get_kills() const;
+        /** @return The changes of the health of the tanks */
+        const std::vector<health_update_t> &get_health_updates() const;
+        /** @return The damage to modules */
+        const std::vector<module_damage_t> &get_module_damage() const;
+        /** @return The destroyed tracks */
+        const std::vector<track_break_t> &get_track_breaks() const;
+        /** @return The messages of the battle log */
+        const std::vector<chat_message_t> &get_chat_messages() const;
+    private:
+        class event_visitor_t;
+        std::vector<kill_t> kills;
+        std::vector<health_update_t> health_updates;
+        std::vector<module_damage_t> module_damage;
+        std::vector<track_break_t> track_breaks;
+        std::vector<chat_message_t> chat_messages;
+        bool built = false;
+    };
+}
+
+#endif /* defined(wotreplay_event_table_h) */
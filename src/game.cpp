@@ -1,4 +1,7 @@
+#include "json/json.h"
+
 #include "game.h"
+#include "packet_cursor.h"
 #include "regex.h"
 
 #include <boost/format.hpp>
@@ -7,17 +10,105 @@
 #include <algorithm>
 #include <fstream>
 #include <iostream>
-#include <unordered_map>
+#include <stdexcept>
 
 using namespace wotreplay;
 
 
 const std::vector<packet_t> &game_t::get_packets() const {
+    const packet_table_t &packet_table = get_packet_table();
+    std::call_once(cache_flags->packets, [&] {
+        packets.clear();
+        packets.reserve(packet_table.size());
+        for (size_t ix = 0; ix < packet_table.size(); ++ix) {
+            packets.push_back(packet_table.packet(ix, replay));
+        }
+    });
     return packets;
 }
 
+const packet_table_t &game_t::get_packet_table() const {
+    std::call_once(cache_flags->packet_table, [&] {
+        packet_cursor_t cursor(*this);
+        while (cursor.next()) {
+            packet_table.push_back(cursor.packet(), static_cast<uint32_t>(cursor.offset()));
+        }
+        packet_table.shrink_to_fit();
+    });
+    return packet_table;
+}
+
+packet_t game_t::get_packet(size_t ix) const {
+    return get_packet_table().packet(ix, replay);
+}
+
+const trajectory_table_t &game_t::get_trajectories() const {
+    const packet_table_t &packet_table = get_packet_table();
+    std::call_once(cache_flags->trajectories, [&] {
+        trajectories.build(packet_table, replay);
+    });
+    return trajectories;
+}
+
+const event_table_t &game_t::get_events() const {
+    std::call_once(cache_flags->events, [&] {
+        events.build(*this);
+    });
+    return events;
+}
+
+size_t game_t::get_battle_start() const {
+    std::call_once(cache_flags->battle_start, [&] {
+        // a compacted game keeps the start of the battle determined before compacting
+        if (battle_start >= 0) {
+            return;
+        }
+
+        // the game starts after the first packet in which a player moves
+        size_t start = get_packet_table().size();
+
+        for (const trajectory_t &trajectory : get_trajectories().get_trajectories()) {
+            if (get_team_id(trajectory.player_id) < 0) {
+                continue; // belongs to no team
+            }
+
+            for (size_t j = 1; j < trajectory.size() && trajectory.packet_ix[j] < start; ++j) {
+                int distance = dist(trajectory.position(j - 1), trajectory.position(j));
+                if (distance > 0.01) {
+                    start = trajectory.packet_ix[j] + 1;
+                    break;
+                }
+            }
+        }
+
+        battle_start = static_cast<int>(start);
+        battle_start_clock = start < get_packet_table().size() ? get_packet_table().clock(start) : 0.f;
+    });
+    return battle_start;
+}
+
+float game_t::get_battle_start_clock() const {
+    get_battle_start();
+    return battle_start_clock;
+}
+
+size_t game_t::seek(float clock, size_t begin) const {
+    const packet_table_t &packet_table = get_packet_table();
+    // packets without a clock have the clock of the previous packet, the clocks do not decrease
+    size_t end = packet_table.size();
+    while (begin < end) {
+        size_t mid = begin + (end - begin) / 2;
+        if (packet_table.clock(mid) < clock) {
+            begin = mid + 1;
+        } else {
+            end = mid;
+        }
+    }
+    return begin;
+}
+
 const std::string &game_t::get_map_name() const {
-    return arena.name;
+    return get_arena().name;
 }
 
 const std::string &game_t::get_game_mode() const {
@@ -25,7 +116,9 @@ const std::string &game_t::get_game_mode() const {
 }
 
 const arena_t &game_t::get_arena() const {
-    return arena;
+    // the arena is missing when its definition is not found
+    static const arena_t no_arena = arena_t();
+    return arena ? *arena : no_arena;
 }
 
 const std::set<int> &game_t::get_team(int team_id) const {
@@ -37,6 +130,18 @@ uint32_t game_t::get_recorder_id() const {
 }
 
 bool game_t::find_property(uint32_t clock, uint32_t player_id, property_t property, packet_t &out) const {
+    if (property == property_t::position) {
+        const trajectory_t *trajectory = get_trajectories().find(player_id);
+        size_t ix;
+        bool found = trajectory != nullptr && trajectory->find(static_cast<float>(clock), ix);
+        if (found) {
+            out = get_packet(trajectory->packet_ix[ix]);
+        }
+        return found;
+    }
+
+    const std::vector<packet_t> &packets = get_packets();
+
     // inline function function for using with stl to finding the range with the same clock
     auto has_same_clock = [&](const packet_t &target) -> bool  {
         // packets without clock are included
@@ -88,24 +193,52 @@ bool game_t::find_property(uint32_t clock, uint32_t player_id, property_t proper
 }
 
 int game_t::get_team_id(int player_id) const {
-    auto it = std::find_if(teams.begin(), teams.end(), [&](const std::set<int> &team) {
-        return team.find(player_id) != team.end();
-    });
-    return it == teams.end() ? -1 : (static_cast<int>(it - teams.begin()));
+    return player_table.get_team_id(static_cast<uint32_t>(player_id));
 }
 
 const version_t &game_t::get_version() const {
     return version;
 }
 
-const buffer_t &game_t::get_game_begin() const {
+const slice_t &game_t::get_game_begin() const {
     return game_begin;
 }
 
-const buffer_t &game_t::get_game_end() const {
+const slice_t &game_t::get_game_end() const {
     return game_end;
 }
 
+/**
+ * Parse a json data block once.
+ * @param block The data block
+ * @param document The parsed document, created on first use
+ * @return The parsed document
+ */
+static std::shared_ptr<Json::Value> parse_json(const slice_t &block) {
+    auto document = std::make_shared<Json::Value>();
+    if (!block.empty()) {
+        Json::Reader reader;
+        reader.parse(reinterpret_cast<const char*>(block.begin()), reinterpret_cast<const char*>(block.end()),
+                     *document);
+    }
+
+    return document;
+}
+
+const Json::Value &game_t::get_game_begin_json() const {
+    std::call_once(cache_flags->game_begin_json, [&] {
+        game_begin_json = parse_json(game_begin);
+    });
+    return *game_begin_json;
+}
+
+const Json::Value &game_t::get_game_end_json() const {
+    std::call_once(cache_flags->game_end_json, [&] {
+        game_end_json = parse_json(game_end);
+    });
+    return *game_end_json;
+}
+
 const buffer_t &game_t::get_raw_replay() const {
     return replay;
 }
@@ -199,54 +332,65 @@ double wotreplay::dist(const std::tuple<float, float, float> &begin,
 }
 
 int wotreplay::get_start_packet (const game_t &game, double skip) {
-    std::unordered_map<int, packet_t> last_packets;
-    int i = 0;
+    size_t start = game.get_battle_start();
 
-    for (const auto &packet : game.get_packets()) {
-        i++;
-
-        if (!packet.has_property(property_t::position)) {
-            continue;
-        }
-
-        int player_id = packet.player_id(),
-        team_id = game.get_team_id(player_id);
-
-
-        if (team_id < 0) {
-            continue; // belongs to no team
-        }
-
-        auto last = last_packets.find(player_id);
-        if (last != last_packets.end()) {
-            int distance = dist(last->second.position(), packet.position());
-            if (distance > 0.01) {
-                break;
-            }
-        }
-
-        last_packets[player_id] = packet;
+    if (start < game.get_packet_table().size()) {
+        float clock = game.get_battle_start_clock(),
+        offset = skip;
+        start = game.seek(clock + offset, start);
     }
 
-    const auto &packets = game.get_packets();
+    return start;
+}
 
-    if (i < packets.size()) {
-        float clock = packets[i].clock(),
-        offset = skip;
-        for (auto it = packets.begin() + i; it != packets.end(); ++it) {
-            if (it->has_property(property_t::clock) &&
-                it->clock() >= clock + offset) {
-                break;
-            }
-            ++i;
+void game_t::compact(const std::vector<uint32_t> &types) {
+    // the start of the battle depends on all packets, determine it before they are released
+    size_t start = get_battle_start();
+    size_t start_offset = start < get_packet_table().size() ? get_packet_table().offset(start) : replay.size();
+
+    buffer_t compact_replay;
+    size_t compact_start = 0;
+    packet_cursor_t cursor(*this, types);
+    while (cursor.next()) {
+        if (cursor.offset() < start_offset) {
+            compact_start += 1;
         }
+        const slice_t &data = cursor.packet().get_data();
+        compact_replay.insert(compact_replay.end(), data.begin(), data.end());
     }
-    
-    return i;
+    compact_replay.shrink_to_fit();
+
+    reset_caches();
+    packets = std::vector<packet_t>();
+    packet_table = packet_table_t();
+    trajectories = trajectory_table_t();
+    events = event_table_t();
+    replay.swap(compact_replay);
+    battle_start = static_cast<int>(compact_start);
+
+    game_begin = slice_t();
+    player_info = slice_t();
+    game_end = slice_t();
+    storage.reset();
+}
+
+void game_t::reset_caches() {
+    cache_flags.reset(new cache_flags_t());
+    packet_table.clear();
+    packets.clear();
+    trajectories.clear();
+    events.clear();
+    battle_start = -1;
+    game_begin_json.reset();
+    game_end_json.reset();
 }
 
 const player_t &game_t::get_player(int player) const {
-    return players.at(player);
+    int ix = player_table.find(static_cast<uint32_t>(player));
+    if (ix < 0) {
+        throw std::out_of_range((boost::format("unknown player id %1%") % player).str());
+    }
+    return player_table.get_player(ix);
 }
 
 game_title_t game_t::get_game_title() const {
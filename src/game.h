@@ -1,10 +1,18 @@
 #ifndef wotreplay_game_h
 #define wotreplay_game_h
 
+#include "json/json-forwards.h"
+
 #include "arena.h"
+#include "event_table.h"
 #include "packet.h"
+#include "packet_table.h"
+#include "player_table.h"
+#include "trajectory.h"
 #include "types.h"
 
+#include <memory>
+#include <mutex>
 #include <set>
 #include <vector>
 
@@ -39,19 +47,11 @@ namespace wotreplay {
         std::string text;
     };
 
-    /**
-     * Player information
-     */
-    struct player_t {
-        uint32_t player_id;
-        int team;
-        std::string name;
-        std::string tank;
-    };
-
     /**
      * An object wrapping the properties of the game with the actions
-     * by the players in the game represented by a list of packets.
+     * by the players in the game represented by a list of packets. The packet table, packets, trajectories,
+     * events, start of the battle and JSON documents are created on first use; the creation is guarded, so
+     * a parsed game can be read from multiple threads through a const reference.
      */
     class game_t {
         friend class parser_t;
@@ -68,14 +68,55 @@ namespace wotreplay {
         const std::string &get_map_name() const;
         /**
          * Returns the data block 'replay' containing a sequence of packets describing the actions in the game. This method
-         * is not supported for replays before version 0.7.2.
+         * is not supported for replays before version 0.7.2. A compacted game only contains the kept packets.
          * @return Data block 'replay'
          */
         const buffer_t &get_raw_replay() const;
         /**
+         * Returns all the packets of this game. The collection is created on the first call, prefer
+         * packet_cursor_t for a single pass over the packets.
          * @return A collection with all the packets of this game.
          */
         const std::vector<packet_t> &get_packets() const;
+        /**
+         * Returns the packets of this game, stored as a set of columns. The table is created on the first call.
+         * @return The packet table of this game.
+         */
+        const packet_table_t &get_packet_table() const;
+        /**
+         * Get a packet from the packet table.
+         * @param ix The index of the packet in the packet table.
+         * @return The packet
+         */
+        packet_t get_packet(size_t ix) const;
+        /**
+         * Returns the trajectories of the players, created from the position packets on the first call.
+         * @return The trajectories of this game.
+         */
+        const trajectory_table_t &get_trajectories() const;
+        /**
+         * Returns the events of the game (destroyed tanks, health updates, module damage, destroyed
+         * tracks and messages), extracted from the packets on the first call.
+         * @return The events of this game.
+         */
+        const event_table_t &get_events() const;
+        /**
+         * Returns the index of the packet at which the battle starts: the packet after the first
+         * movement of a player of one of the teams. Determined from the trajectories on the first call.
+         * @return The index of the packet at the start of the battle, the number of packets if no player moves.
+         */
+        size_t get_battle_start() const;
+        /**
+         * @return The clock of the packet at the start of the battle, see get_battle_start().
+         */
+        float get_battle_start_clock() const;
+        /**
+         * Find the first packet at or after a clock with a binary search on the clocks of the packets.
+         * @param clock The clock to seek to
+         * @param begin Index of the first packet to consider
+         * @return The index of the first packet from begin with a clock of at least \c clock, the number of packets if there is none
+         */
+        size_t seek(float clock, size_t begin = 0) const;
         /**
          * Get the players associated with a team.
          * @param team_id The team for which to get the players
@@ -94,7 +135,8 @@ namespace wotreplay {
         uint32_t get_recorder_id() const;
         /**
          * Tries to find the required property which is the closest (with respect to \c clock) to the specified packet. This method uses the properties
-         * \c property::player_id and \c property_t::clock from the packet referenced by packet_id.
+         * \c property::player_id and \c property_t::clock from the packet referenced by packet_id. Positions are looked up in the
+         * trajectory of the player.
          * @param clock the reference clock to determine the distance of the packet
          * @param player_id the player id for which to find a packet with a property
          * @param property required property of the packet to be found
@@ -117,31 +159,85 @@ namespace wotreplay {
          * Returns the data block 'game begin' containing a JSON string describing the start of the game.
          * @return Data block 'game begin'
          */
-        const buffer_t &get_game_begin() const;
+        const slice_t &get_game_begin() const;
         /**
          * Returns the data block 'game end' containing a JSON string describing the end
          * of the game. . This method is not supported for replays before version 0.7.2.
          * @return Data block 'game end'
          */
-        const buffer_t &get_game_end() const;
+        const slice_t &get_game_end() const;
+        /**
+         * Returns the data block 'game begin' as JSON document, the document is parsed on first use.
+         * @return The document, null if the data block is missing
+         */
+        const Json::Value &get_game_begin_json() const;
+        /**
+         * Returns the data block 'game end' as JSON document, the document is parsed on first use.
+         * @return The document, null if the data block is missing
+         */
+        const Json::Value &get_game_end_json() const;
         /**
          * Get player information with the player id
          * @return Player information
          */
         const player_t &get_player(int player_id) const;
 		game_title_t get_game_title() const;
+        /**
+         * Releases the data which is not needed after parsing: only the packets of the given types are kept
+         * in the raw replay, the data blocks 'game begin', 'player info' and 'game end' are released together
+         * with the replay file. The metadata (players, teams, arena, version) and the start of the battle
+         * remain available, the packet table, trajectories and events are created from the kept packets.
+         * @param types The packet types to keep, all packets if empty
+         */
+        void compact(const std::vector<uint32_t> &types);
     private:
-        std::vector<packet_t> packets;
+        /** guards of the members created on first use */
+        struct cache_flags_t {
+            std::once_flag packet_table;
+            std::once_flag packets;
+            std::once_flag trajectories;
+            std::once_flag events;
+            std::once_flag battle_start;
+            std::once_flag game_begin_json;
+            std::once_flag game_end_json;
+        };
+        /**
+         * Releases the members created on first use, they are created again from the current data blocks.
+         * Not safe while the game is read by other threads.
+         */
+        void reset_caches();
+        /** guards of the members created on first use, replaced by reset_caches() */
+        std::unique_ptr<cache_flags_t> cache_flags { new cache_flags_t() };
+        /** packets read from replay by get_packet_table() */
+        mutable packet_table_t packet_table;
+        /** packets created from packet_table by get_packets() */
+        mutable std::vector<packet_t> packets;
+        /** positions of each player, created by get_trajectories() */
+        mutable trajectory_table_t trajectories;
+        /** events of the game, created by get_events() */
+        mutable event_table_t events;
+        /** packet index at the start of the battle, -1 until determined by get_battle_start() */
+        mutable int battle_start = -1;
+        /** clock of the packet at the start of the battle, kept when the game is compacted */
+        mutable float battle_start_clock = 0.f;
+        /** data block 'game begin' parsed by get_game_begin_json() */
+        mutable std::shared_ptr<Json::Value> game_begin_json;
+        /** data block 'game end' parsed by get_game_end_json() */
+        mutable std::shared_ptr<Json::Value> game_end_json;
         std::array<std::set<int>, 2> teams;
         std::string game_mode;
-        arena_t arena;
-        buffer_t game_begin;
-        buffer_t player_info;
-        buffer_t game_end;
+        /** arena of the game, shared with the arena definitions */
+        std::shared_ptr<const arena_t> arena;
+        /** owner of the memory referenced by the data blocks (a mapped file or a buffer) */
+        std::shared_ptr<const void> storage;
+        slice_t game_begin;
+        slice_t player_info;
+        slice_t game_end;
         buffer_t replay;
         uint32_t recorder_id;
         version_t version;
-        std::map<int, player_t> players;
+        /** players of the game, created by parser_t::read_player_info */
+        player_table_t player_table;
 		game_title_t title;
     };
 
@@ -173,7 +269,8 @@ namespace wotreplay {
 
     /**
      * @fn int wotreplay::get_start_packet(const game_t &game, double skip)
-     * Determine offset of first packet a number of seconds after the game has started
+     * Determine offset of first packet a number of seconds after the game has started, the start
+     * of the battle is determined once per game, the packet is found with a binary search on clock.
      * @param game game information
      * @param skip number of seconds since start of game
      * @return offset for first packet
@@ -1,5 +1,6 @@
 #include "heatmap_writer.h"
 #include "image_util.h"
+#include "packet_visitor.h"
 
 #include <boost/algorithm/clamp.hpp>
 
@@ -164,48 +165,153 @@ int heatmap_writer_t::get_class(const game_t &game, const packet_t &packet) cons
     return game.get_team_id(packet.player_id());
 }
 
+class heatmap_writer_t::update_visitor_t : public packet_visitor_t<update_visitor_t> {
+public:
+    update_visitor_t(heatmap_writer_t &writer)
+        : writer(writer)
+    {}
+
+    void on_packet(const game_t &game, const packet_t &packet) {
+        if (!writer.advance(game, packet)) {
+            writer.pending.clear();
+        }
+    }
+
+    void on_position(const game_t &game, const packet_t &packet, const position_event_t &event) {
+        if (writer.advance(game, packet)) {
+            writer.add_position(game, packet);
+        } else {
+            // the last position before the start of the battle is included, keep a copy until it is known
+            writer.pending.assign(packet.get_data().begin(), packet.get_data().end());
+        }
+    }
+
+    void on_tank_destroyed(const game_t &game, const packet_t &packet, const tank_destroyed_event_t &event) {
+        on_packet(game, packet);
+        writer.dead_players.insert(event.target);
+    }
+private:
+    heatmap_writer_t &writer;
+};
+
 void heatmap_writer_t::update(const wotreplay::game_t &game) {
-    std::set<int> dead_players;
+    begin(game);
+
+    // the start of the battle is known, seek to it instead of detecting it
+    const packet_table_t &packet_table = game.get_packet_table();
+    size_t start = get_start_packet(game, skip);
+    // the last position before the start of the battle is included
+    if (start > 0 && packet_table.has_property(start - 1, property_t::position)) {
+        start -= 1;
+    }
 
-    const auto &packets = game.get_packets();
-    int offset = get_start_packet(game, skip);
-    for (auto it = packets.cbegin(); it != packets.cend() ; it++) {
-        const auto &packet = *it;
+    for (size_t ix = 0; ix < start; ++ix) {
+        if (packet_table.has_property(ix, property_t::tank_destroyed)) {
+            dead_players.insert(std::get<0>(game.get_packet(ix).tank_destroyed()));
+        }
+    }
+
+    start_state = start_state_t::started;
+    update_visitor_t visitor(*this);
+    for (size_t ix = start; ix < packet_table.size(); ++ix) {
+        visitor.visit(game, game.get_packet(ix));
+    }
+    end(game);
+}
 
-        offset -= 1;
+bool heatmap_writer_t::is_streaming() const {
+    return true;
+}
+
+void heatmap_writer_t::begin(const game_t &game) {
+    dead_players.clear();
+    last_positions.clear();
+    pending.clear();
+    start_state = start_state_t::detect_movement;
+}
+
+void heatmap_writer_t::update(const game_t &game, const packet_t &packet) {
+    update_visitor_t(*this).visit(game, packet);
+}
 
-        if (offset > 0 || !packet.has_property(property_t::position)) {
-            if (packet.has_property(property_t::tank_destroyed)) {
-                uint32_t target, killer;
-                uint8_t type;
-                std::tie(target, killer, type) = packet.tank_destroyed();
-                dead_players.insert(target);
+void heatmap_writer_t::end(const game_t &game) {
+    // without a detected start, only the last packet is included
+    if (start_state != start_state_t::started && !pending.empty()) {
+        add_position(game, packet_t(slice_t(pending.data(), pending.data() + pending.size())));
+    }
+    pending.clear();
+}
+
+bool heatmap_writer_t::advance(const game_t &game, const packet_t &packet) {
+    if (start_state != start_state_t::started && !detect_start(game, packet)) {
+        return false;
+    }
+
+    if (!pending.empty()) {
+        add_position(game, packet_t(slice_t(pending.data(), pending.data() + pending.size())));
+        pending.clear();
+    }
+
+    return true;
+}
+
+bool heatmap_writer_t::detect_start(const game_t &game, const packet_t &packet) {
+    switch (start_state) {
+        case start_state_t::detect_movement: {
+            if (!packet.has_property(property_t::position) || game.get_team_id(packet.player_id()) < 0) {
+                return false;
             }
-            continue;
-        }
 
-        uint32_t player_id = packet.player_id();
-        int class_id;
-        if (dead_players.count(player_id) != 0 || (class_id = this->get_class(game, packet)) < 0) {
-            continue;
+            int player_id = packet.player_id();
+            auto last = last_positions.find(player_id);
+            if (last != last_positions.end()) {
+                int distance = dist(last->second, packet.position());
+                if (distance > 0.01) {
+                    start_state = start_state_t::start_clock;
+                    return false;
+                }
+            }
+
+            last_positions[player_id] = packet.position();
+            return false;
         }
+        case start_state_t::start_clock:
+            start_clock = packet.clock() + skip;
+            start_state = start_state_t::skip_time;
+            // fall through
+        case start_state_t::skip_time:
+            if (packet.has_property(property_t::clock) && packet.clock() >= start_clock) {
+                start_state = start_state_t::started;
+                return true;
+            }
+            return false;
+        default:
+            return true;
+    }
+}
 
-        const bounding_box_t &bounding_box = game.get_arena().bounding_box;
-        std::tuple<float, float> position = get_2d_coord(packet.position(), bounding_box, image_width, image_height);
+void heatmap_writer_t::add_position(const game_t &game, const packet_t &packet) {
+    uint32_t player_id = packet.player_id();
+    int class_id;
+    if (dead_players.count(player_id) != 0 || (class_id = this->get_class(game, packet)) < 0) {
+        return;
+    }
 
-        float x = std::get<0>(position);
-        float y = std::get<1>(position);
+    const bounding_box_t &bounding_box = game.get_arena().bounding_box;
+    std::tuple<float, float> position = get_2d_coord(packet.position(), bounding_box, image_width, image_height);
 
-        int ll_x = std::floor(x), ll_y = std::floor(y);
-        int ul_x = ll_x + 1, ul_y = ll_y + 1;
+    float x = std::get<0>(position);
+    float y = std::get<1>(position);
 
-        if (ll_x >= 0 && ll_y >= 0 && ul_x < image_width && ul_y < image_height) {
-            float px = x - ll_x, py = y - ll_y;
+    int ll_x = std::floor(x), ll_y = std::floor(y);
+    int ul_x = ll_x + 1, ul_y = ll_y + 1;
 
-            positions[class_id][ll_y][ll_x] += (1 - px) * (1 - py);
-            positions[class_id][ul_y][ll_x] += (1 - px) *  py;
-            positions[class_id][ll_y][ul_x] +=  px      * (1 - py);
-            positions[class_id][ul_y][ul_x] +=  px      *  py;
-        }
+    if (ll_x >= 0 && ll_y >= 0 && ul_x < image_width && ul_y < image_height) {
+        float px = x - ll_x, py = y - ll_y;
+
+        positions[class_id][ll_y][ll_x] += (1 - px) * (1 - py);
+        positions[class_id][ul_y][ll_x] += (1 - px) *  py;
+        positions[class_id][ll_y][ul_x] +=  px      * (1 - py);
+        positions[class_id][ul_y][ul_x] +=  px      *  py;
     }
-}
\ No newline at end of file
+}
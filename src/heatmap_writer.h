@@ -3,6 +3,10 @@
 
 #include "image_writer.h"
 
+#include <set>
+#include <tuple>
+#include <unordered_map>
+
 /** @file */
 
 namespace wotreplay {
@@ -19,6 +23,10 @@ namespace wotreplay {
     public:
         heatmap_writer_t();
         virtual void update(const game_t &game) override;
+        virtual bool is_streaming() const override;
+        virtual void begin(const game_t &game) override;
+        virtual void update(const game_t &game, const packet_t &packet) override;
+        virtual void end(const game_t &game) override;
         virtual int  get_class(const game_t &game, const packet_t &packet) const;
         virtual void finish() override;
         /** Skip number of seconds after start of battle */
@@ -27,6 +35,43 @@ namespace wotreplay {
         std::tuple<double, double> bounds;
         /** Heatmap mode */
         heatmap_mode_t mode;
+    private:
+        /** Progress of detecting the start of the battle, see wotreplay::get_start_packet */
+        enum class start_state_t {
+            /** waiting for the first player to move */
+            detect_movement,
+            /** waiting for the first packet after the movement, to determine the start clock */
+            start_clock,
+            /** skipping the number of seconds specified by skip */
+            skip_time,
+            /** the battle has started */
+            started
+        };
+        /**
+         * Advance the detection of the start of the battle with a packet.
+         * @return \c true if the battle starts with this packet
+         */
+        bool detect_start(const game_t &game, const packet_t &packet);
+        /**
+         * Advance the detection of the start of the battle with a packet, the pending position is
+         * added once the battle has started.
+         * @return \c true if the battle has started
+         */
+        bool advance(const game_t &game, const packet_t &packet);
+        /**
+         * Add the position of a packet to the heatmap.
+         */
+        void add_position(const game_t &game, const packet_t &packet);
+        /** players destroyed in the current game */
+        std::set<int> dead_players;
+        /** last known position of the players while detecting the start of the battle */
+        std::unordered_map<int, std::tuple<float, float, float>> last_positions;
+        /** last position packet before the start of the battle, it is included in the heatmap */
+        buffer_t pending;
+        start_state_t start_state;
+        float start_clock;
+        /** handles the packets passed to heatmap_writer_t::update */
+        class update_visitor_t;
     };
 
     /**
@@ -2,6 +2,7 @@
 #include "image_util.h"
 #include "image_writer.h"
 #include "logger.h"
+#include "packet_visitor.h"
 
 #include <fstream>
 #include <iostream>
@@ -149,23 +150,32 @@ void image_writer_t::draw_position(const packet_t &packet, const game_t &game, b
     }
 }
 
-void image_writer_t::update(const game_t &game) {
+class image_writer_t::update_visitor_t : public packet_visitor_t<update_visitor_t> {
+public:
+    update_visitor_t(image_writer_t &writer)
+        : writer(writer)
+    {}
+
+    void on_position(const game_t &game, const packet_t &packet, const position_event_t &event) {
+        writer.draw_position(packet, game, writer.positions);
+    }
+
+    void on_tank_destroyed(const game_t &game, const packet_t &packet, const tank_destroyed_event_t &event) {
+        dead_players.insert(event.target);
+        writer.draw_death(packet, game);
+    }
+private:
+    image_writer_t &writer;
     std::set<int> dead_players;
+};
+
+void image_writer_t::update(const game_t &game) {
     recorder_team = game.get_team_id(game.get_recorder_id());
-    
+
+    update_visitor_t visitor(*this);
     for (const packet_t &packet : game.get_packets()) {
         if (!filter(packet)) continue;
-        if (packet.has_property(property_t::position)) {
-            // && dead_players.find(packet.player_id()) == dead_players.end()) {
-            draw_position(packet, game, this->positions);
-        }
-        else if (packet.has_property(property_t::tank_destroyed)) {
-            uint32_t target, killer;
-            uint8_t type;
-            std::tie(target, killer, type) = packet.tank_destroyed();
-            dead_players.insert(target);
-            draw_death(packet, game);
-        }
+        visitor.visit(game, packet);
     }
 }
 
@@ -298,6 +308,11 @@ void image_writer_t::set_filter(filter_t filter) {
     this->filter = filter;
 }
 
+std::vector<uint32_t> image_writer_t::get_packet_types() const {
+    // the positions and the destroyed tanks
+    return { 0x08, 0x0a };
+}
+
 const arena_t &image_writer_t::get_arena() const {
     return arena;
 }
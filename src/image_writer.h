@@ -26,6 +26,7 @@ namespace wotreplay {
         virtual void init(const arena_t &arena, const std::string &mode) override;
         virtual void clear() override;
         virtual void set_filter(filter_t filter) override;
+        virtual std::vector<uint32_t> get_packet_types() const override;
         /**
          * Set if the recording player should be drawn on the map in a seperate color.
          * @param show_self Show the recording player ?
@@ -172,6 +173,9 @@ namespace wotreplay {
         int image_width;
         int image_height;
         bool no_basemap;
+    private:
+        /** draws the packets passed to image_writer_t::update */
+        class update_visitor_t;
     };
 }
 
@@ -0,0 +1,311 @@
+#include "json_scanner.h"
+
+#include <climits>
+#include <cstring>
+
+using namespace wotreplay;
+
+json_scanner_t::json_scanner_t(const uint8_t *begin, const uint8_t *end)
+    : pos(begin), end(end), malformed(false)
+{}
+
+const uint8_t *json_scanner_t::tell() const {
+    return pos;
+}
+
+void json_scanner_t::seek(const uint8_t *pos) {
+    if (!malformed) {
+        this->pos = pos;
+    }
+}
+
+bool json_scanner_t::failed() const {
+    return malformed;
+}
+
+void json_scanner_t::fail() {
+    malformed = true;
+    pos = end;
+}
+
+uint8_t json_scanner_t::peek() {
+    while (pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\r' || *pos == '\n')) {
+        ++pos;
+    }
+    return pos < end ? *pos : 0;
+}
+
+bool json_scanner_t::begin_object() {
+    if (peek() == '{') {
+        ++pos;
+        return true;
+    }
+
+    skip_value();
+    return false;
+}
+
+bool json_scanner_t::next_key(std::string &key) {
+    uint8_t c = peek();
+    if (c == ',') {
+        ++pos;
+        c = peek();
+    }
+
+    if (c == '}') {
+        ++pos;
+        return false;
+    }
+
+    if (c != '"' || !read_quoted(key) || peek() != ':') {
+        fail();
+        return false;
+    }
+
+    ++pos;
+    return true;
+}
+
+bool json_scanner_t::begin_array() {
+    if (peek() == '[') {
+        ++pos;
+        return true;
+    }
+
+    skip_value();
+    return false;
+}
+
+bool json_scanner_t::next_element() {
+    uint8_t c = peek();
+    if (c == ',') {
+        ++pos;
+        c = peek();
+    }
+
+    if (c == ']') {
+        ++pos;
+        return false;
+    }
+
+    if (c == 0) {
+        fail();
+        return false;
+    }
+
+    return true;
+}
+
+bool json_scanner_t::read_string(std::string &value) {
+    uint8_t c = peek();
+    if (c == '"') {
+        return read_quoted(value);
+    }
+
+    if (c == '{' || c == '[' || c == 0) {
+        skip_value();
+        return false;
+    }
+
+    const uint8_t *last = scalar_end();
+    if (last - pos == 4 && std::memcmp(pos, "null", 4) == 0) {
+        value.clear();
+    } else {
+        value.assign(pos, last);
+    }
+
+    pos = last;
+    return true;
+}
+
+bool json_scanner_t::read_int(int &value) {
+    uint8_t c = peek();
+    if (c != '-' && (c < '0' || c > '9')) {
+        skip_value();
+        return false;
+    }
+
+    const uint8_t *last = scalar_end();
+    bool negative = c == '-';
+    const long long limit = negative ? -static_cast<long long>(INT_MIN) : INT_MAX;
+    long long result = 0;
+    for (const uint8_t *p = negative ? pos + 1 : pos; p < last && *p >= '0' && *p <= '9'; ++p) {
+        result = result * 10 + (*p - '0');
+        if (result > limit) {
+            // the value does not fit in an int, it is skipped
+            pos = last;
+            return false;
+        }
+    }
+
+    value = static_cast<int>(negative ? -result : result);
+    pos = last;
+    return true;
+}
+
+void json_scanner_t::skip_value() {
+    uint8_t c = peek();
+    if (c == '"') {
+        skip_quoted();
+        return;
+    }
+
+    if (c == '{' || c == '[') {
+        // the nesting is not validated, only the depth is tracked
+        int depth = 0;
+        while (pos < end) {
+            c = *pos;
+            if (c == '"') {
+                skip_quoted();
+                continue;
+            }
+
+            ++pos;
+            if (c == '{' || c == '[') {
+                ++depth;
+            } else if ((c == '}' || c == ']') && --depth == 0) {
+                return;
+            }
+        }
+
+        fail();
+        return;
+    }
+
+    const uint8_t *last = scalar_end();
+    if (last == pos) {
+        fail();
+        return;
+    }
+
+    pos = last;
+}
+
+const uint8_t *json_scanner_t::scalar_end() const {
+    const uint8_t *p = pos;
+    while (p < end && *p != ',' && *p != '}' && *p != ']' && *p != ' ' &&
+           *p != '\t' && *p != '\r' && *p != '\n') {
+        ++p;
+    }
+    return p;
+}
+
+void json_scanner_t::skip_quoted() {
+    for (++pos; pos < end; ++pos) {
+        if (*pos == '\\') {
+            ++pos;
+        } else if (*pos == '"') {
+            ++pos;
+            return;
+        }
+    }
+
+    fail();
+}
+
+/**
+ * Read 4 hexadecimal digits.
+ * @return \c false if the digits are invalid
+ */
+static bool read_hex(const uint8_t *p, const uint8_t *end, unsigned int &value) {
+    if (end - p < 4) {
+        return false;
+    }
+
+    value = 0;
+    for (int ix = 0; ix < 4; ++ix) {
+        uint8_t c = p[ix];
+        unsigned int digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            return false;
+        }
+        value = value * 16 + digit;
+    }
+    return true;
+}
+
+/** Append a code point encoded as UTF-8 */
+static void append_utf8(std::string &value, unsigned int cp) {
+    if (cp < 0x80) {
+        value += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        value += static_cast<char>(0xC0 | (cp >> 6));
+        value += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        value += static_cast<char>(0xE0 | (cp >> 12));
+        value += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        value += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        value += static_cast<char>(0xF0 | (cp >> 18));
+        value += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        value += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        value += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+bool json_scanner_t::read_quoted(std::string &value) {
+    value.clear();
+    ++pos;
+
+    while (pos < end) {
+        // copy the characters up to the next escape sequence or the closing quote at once
+        const uint8_t *first = pos;
+        while (pos < end && *pos != '"' && *pos != '\\') {
+            ++pos;
+        }
+        value.append(first, pos);
+
+        if (pos == end) {
+            break;
+        }
+
+        if (*pos == '"') {
+            ++pos;
+            return true;
+        }
+
+        if (++pos == end) {
+            break;
+        }
+
+        uint8_t c = *pos++;
+        switch (c) {
+            case 'b': value += '\b'; break;
+            case 'f': value += '\f'; break;
+            case 'n': value += '\n'; break;
+            case 'r': value += '\r'; break;
+            case 't': value += '\t'; break;
+            case 'u': {
+                unsigned int cp;
+                if (!read_hex(pos, end, cp)) {
+                    fail();
+                    return false;
+                }
+                pos += 4;
+
+                // a surrogate pair encodes a code point outside of the basic multilingual plane
+                unsigned int low;
+                if (cp >= 0xD800 && cp <= 0xDBFF && end - pos >= 6 && pos[0] == '\\' && pos[1] == 'u' &&
+                    read_hex(pos + 2, end, low) && low >= 0xDC00 && low <= 0xDFFF) {
+                    cp = 0x10000 + ((cp & 0x3FF) << 10) + (low & 0x3FF);
+                    pos += 6;
+                }
+
+                append_utf8(value, cp);
+                break;
+            }
+            default:
+                value += static_cast<char>(c);
+                break;
+        }
+    }
+
+    fail();
+    return false;
+}
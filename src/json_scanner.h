@@ -0,0 +1,96 @@
+#ifndef wotreplay_json_scanner_h
+#define wotreplay_json_scanner_h
+
+#include <stdint.h>
+#include <string>
+
+/** @file */
+
+namespace wotreplay {
+    /**
+     * wotreplay::json_scanner_t reads selected values from a JSON document in a single pass over the raw
+     * bytes, without building a DOM. The caller walks the document: it enters the objects and arrays it is
+     * interested in and skips the other values. A malformed document stops the scanner, after which all
+     * reads fail, in the same way a failed Json::Reader leaves an empty document.
+     */
+    class json_scanner_t {
+    public:
+        /**
+         * Create a scanner reading the document in [begin, end).
+         * @param begin start of the document
+         * @param end end of the document
+         */
+        json_scanner_t(const uint8_t *begin, const uint8_t *end);
+        /**
+         * @return The position of the scanner, to return to with seek()
+         */
+        const uint8_t *tell() const;
+        /**
+         * Continue scanning at a position returned by tell().
+         * @param pos the position
+         */
+        void seek(const uint8_t *pos);
+        /**
+         * Enter the next value if it is an object, otherwise skip it.
+         * @return \c true if the value is an object
+         */
+        bool begin_object();
+        /**
+         * Read the key of the next member of the current object, the scanner is positioned at its value.
+         * @param key Output variable receiving the key
+         * @return \c true if a member was read, \c false at the end of the object
+         */
+        bool next_key(std::string &key);
+        /**
+         * Enter the next value if it is an array, otherwise skip it.
+         * @return \c true if the value is an array
+         */
+        bool begin_array();
+        /**
+         * Move to the next element of the current array.
+         * @return \c true if the scanner is positioned at an element, \c false at the end of the array
+         */
+        bool next_element();
+        /**
+         * Read the next value as a string, converted like Json::Value::asString: a number or boolean is read
+         * as its text, null as an empty string. An object or array is skipped.
+         * @param value Output variable receiving the value
+         * @return \c true if the value was read
+         */
+        bool read_string(std::string &value);
+        /**
+         * Read the next value as an integer, a fraction is truncated. A number out of the range of an int and
+         * any other value are skipped.
+         * @param value Output variable receiving the value
+         * @return \c true if the value was read
+         */
+        bool read_int(int &value);
+        /**
+         * Skip the next value.
+         */
+        void skip_value();
+        /**
+         * @return \c true if the document is malformed
+         */
+        bool failed() const;
+    private:
+        /** skip white space, @return the next character or 0 at the end */
+        uint8_t peek();
+        /** stop scanning after a malformed value */
+        void fail();
+        /** read the string at pos, decoding the escape sequences */
+        bool read_quoted(std::string &value);
+        /** skip the string at pos */
+        void skip_quoted();
+        /** @return the end of the number or literal at pos */
+        const uint8_t *scalar_end() const;
+        /** current position */
+        const uint8_t *pos;
+        /** end of the document */
+        const uint8_t *end;
+        /** indicates the document is malformed */
+        bool malformed;
+    };
+}
+
+#endif /* defined(wotreplay_json_scanner_h) */
@@ -1,4 +1,5 @@
 #include "json_writer.h"
+#include "packet_visitor.h"
 
 #include <boost/format.hpp>
 
@@ -26,119 +27,139 @@ json_writer_t::json_writer_t()
     : filter([](const packet_t &){ return true; })
 {}
 
-void write(Json::Value &root, const std::string &key, const buffer_t &buffer) {
-    if (buffer.begin() != buffer.end()) {
-        Json::Reader reader;
-        Json::Value value;
-        std::string raw_value(buffer.begin(), buffer.end());
-        reader.parse(raw_value, value);
-        root[key] = value;
-    }
-}
-
-void json_writer_t::update(const game_t &game) {
-    auto &packets = root["packets"];
-
-    bounding_box_t bounding_box(game.get_arena().bounding_box);
-
-    // copy boundary values
-    Json::Value coordinate(Json::arrayValue);
-    coordinate.append(std::get<0>(bounding_box.bottom_left));
-    coordinate.append(std::get<1>(bounding_box.bottom_left));
-    root["map_boundaries"].append(coordinate);
-    coordinate.clear();
-    coordinate.append(std::get<0>(bounding_box.upper_right));
-    coordinate.append(std::get<1>(bounding_box.upper_right));
-    root["map_boundaries"].append(coordinate);
-    
-    root["recorder_id"] = game.get_recorder_id();
+namespace {
+    /** appends the packets of a game to a json array */
+    class packet_json_visitor_t : public packet_visitor_t<packet_json_visitor_t> {
+    public:
+        packet_json_visitor_t(Json::Value &packets)
+            : packets(packets)
+        {}
 
-
-    ::write(root, "summary", game.get_game_begin());
-    ::write(root, "score_card", game.get_game_end());
-
-    const version_t &v = game.get_version();
-
-    for (const auto &packet : game.get_packets()) {
-        // skip empty packet
-        if (!filter(packet)) continue;
-
-        auto &value = packets.append(Json::objectValue);
-
-        if (packet.has_property(property_t::type)) {
-            value["type"] = packet.type();
+        void on_packet(const game_t &game, const packet_t &packet) {
+            append(game, packet);
         }
-        
-        if (packet.has_property(property_t::clock)) {
-            value["clock"] = packet.clock();
+
+        void on_position(const game_t &game, const packet_t &packet, const position_event_t &event) {
+            auto &value = append(game, packet);
+            auto &positionValue = value["position"] = Json::Value(Json::arrayValue);
+            positionValue.append(std::get<0>(event.position));
+            positionValue.append(std::get<1>(event.position));
+            positionValue.append(std::get<2>(event.position));
         }
 
-        if (packet.has_property(property_t::player_id)) {
-            value["player_id"] = packet.player_id();
-            int team_id = game.get_team_id(packet.player_id());
-            if (team_id != -1) {
-                value["team"] = team_id;
-            }
+        void on_health(const game_t &game, const packet_t &packet, const health_event_t &event) {
+            auto &value = append(game, packet);
+            value["health"] = event.health;
         }
 
-        if (packet.has_property(property_t::position)) {
-            auto &positionValue = value["position"] = Json::Value(Json::arrayValue);
-            const auto &position = packet.position();
-            positionValue.append(std::get<0>(position));
-            positionValue.append(std::get<1>(position));
-            positionValue.append(std::get<2>(position));
+        void on_message(const game_t &game, const packet_t &packet, const message_event_t &event) {
+            auto &value = append(game, packet);
+            value["message"] = event.message;
         }
 
-        if (packet.has_property(property_t::tank_destroyed)) {
-            uint32_t target, destroyed_by;
-            uint8_t type;
-            std::tie(target, destroyed_by, type) = packet.tank_destroyed();
-            value["target"] = target;
-            value["destroyed_by"] = destroyed_by;
-            if (type == 0) {
+        void on_tank_destroyed(const game_t &game, const packet_t &packet, const tank_destroyed_event_t &event) {
+            auto &value = append(game, packet);
+            value["target"] = event.target;
+            value["destroyed_by"] = event.destroyed_by;
+            if (event.type == 0) {
                 value["destruction_type"] = "shell";
             }
-            else if (type == 1) {
+            else if (event.type == 1) {
                 value["destruction_type"] = "fire";
             }
-            else if (type == 2) {
+            else if (event.type == 2) {
                 value["destruction_type"] = "ram";
             }
-            else if (type == 3) {
+            else if (event.type == 3) {
                 value["destruction_type"] = "crash";
             }
             else  {
-                value["destruction_type"] = (boost::format("unknown (%1%)") % uint32_t(type)).str();
+                value["destruction_type"] = (boost::format("unknown (%1%)") % uint32_t(event.type)).str();
+            }
+
+            // the signature of a destroyed tank does not exclude a health update
+            if (packet.has_property(property_t::health)) {
+                value["health"] = packet.health();
             }
         }
+    private:
+        /** append a packet with the properties shared by all packet types */
+        Json::Value &append(const game_t &game, const packet_t &packet) {
+            auto &value = packets.append(Json::objectValue);
 
-        if (packet.has_property(property_t::health)) {
-            value["health"] = packet.health();
-        }        
+            value["type"] = packet.type();
 
-        if (packet.has_property(property_t::message)) {
-            value["message"] = packet.message();
-        }
+            if (packet.has_property(property_t::clock)) {
+                value["clock"] = packet.clock();
+            }
 
-        if (packet.has_property(property_t::sub_type)) {
-            value["sub_type"] = packet.sub_type();
-        }
-        
-        // if (packet.has_property(property_t::source)) {
-        //     value["source"] = packet.source();
-        // }
+            if (packet.has_property(property_t::player_id)) {
+                value["player_id"] = packet.player_id();
+                int team_id = game.get_team_id(packet.player_id());
+                if (team_id != -1) {
+                    value["team"] = team_id;
+                }
+            }
 
-        // if (packet.has_property(property_t::target)) {
-        //     value["target"] = packet.target();
-        // }
+            if (packet.has_property(property_t::sub_type)) {
+                value["sub_type"] = packet.sub_type();
+            }
 
-        if (packet.has_property(property_t::destroyed_track_id)) {
-            value["destroyed_track_id"] = packet.destroyed_track_id();
-        }
+            // if (packet.has_property(property_t::source)) {
+            //     value["source"] = packet.source();
+            // }
+
+            // if (packet.has_property(property_t::target)) {
+            //     value["target"] = packet.target();
+            // }
 
-        if (packet.has_property(property_t::alt_track_state)) {
-            value["alt_track_state"] = packet.alt_track_state();
+            if (packet.has_property(property_t::destroyed_track_id)) {
+                value["destroyed_track_id"] = packet.destroyed_track_id();
+            }
+
+            if (packet.has_property(property_t::alt_track_state)) {
+                value["alt_track_state"] = packet.alt_track_state();
+            }
+
+            return value;
         }
+
+        Json::Value &packets;
+    };
+}
+
+void json_writer_t::update(const game_t &game) {
+    auto &packets = root["packets"];
+
+    bounding_box_t bounding_box(game.get_arena().bounding_box);
+
+    // copy boundary values
+    Json::Value coordinate(Json::arrayValue);
+    coordinate.append(std::get<0>(bounding_box.bottom_left));
+    coordinate.append(std::get<1>(bounding_box.bottom_left));
+    root["map_boundaries"].append(coordinate);
+    coordinate.clear();
+    coordinate.append(std::get<0>(bounding_box.upper_right));
+    coordinate.append(std::get<1>(bounding_box.upper_right));
+    root["map_boundaries"].append(coordinate);
+    
+    root["recorder_id"] = game.get_recorder_id();
+
+
+    // the documents are parsed once per game, when several writers use them
+    if (!game.get_game_begin().empty()) {
+        root["summary"] = game.get_game_begin_json();
+    }
+
+    if (!game.get_game_end().empty()) {
+        root["score_card"] = game.get_game_end_json();
+    }
+
+    packet_json_visitor_t visitor(packets);
+    for (const auto &packet : game.get_packets()) {
+        // skip empty packet
+        if (!filter(packet)) continue;
+        visitor.visit(game, packet);
     }
 }
 
@@ -1,5 +1,6 @@
 #include "image_writer.h"
 #include "animation_writer.h"
+#include "catalog.h"
 #include "heatmap_writer.h"
 #include "class_heatmap_writer.h"
 #include "json_writer.h"
@@ -20,6 +21,7 @@
 #include <tbb/flow_graph.h>
 #endif // ifdef ENABLE_TBB
 
+#include <algorithm>
 #include <fstream>
 #include <float.h>
 
@@ -99,8 +101,8 @@ int create_minimaps(const po::variables_map &vm, const std::string &output, bool
     init_arena_definition();
 
     image_writer_t writer;
-    for (const auto &arena_entry : get_arenas()) {
-        const arena_t &arena = arena_entry.second;
+    for (const auto &arena_entry : *get_arenas()) {
+        const arena_t &arena = *arena_entry.second;
         for (const auto &configuration_entry : arena.configurations) {
             for (int team_id : { 0, 1 }) {
                 generate_minimap(arena, configuration_entry.first, team_id, output);
@@ -111,6 +113,21 @@ int create_minimaps(const po::variables_map &vm, const std::string &output, bool
     return EX_OK;
 }
 
+int create_catalog(const po::variables_map &vm, const std::string &output) {
+    std::string path = vm.count("output") > 0 ? output : catalog_path;
+
+    try {
+        write_catalog(path, read_arena_definitions(), read_tank_definitions());
+    }
+    catch (const std::exception &exc) {
+        logger.writef(log_level_t::error, "Failed to create %1%: %2%\n", path, exc.what());
+        return EX_SOFTWARE;
+    }
+
+    logger.writef(log_level_t::info, "Created %1%\n", path);
+    return EX_OK;
+}
+
 void apply_settings(image_writer_t * const writer, const po::variables_map &vm) {
     writer->set_image_width(vm["size"].as<int>());
     writer->set_image_height(vm["size"].as<int>());
@@ -194,8 +211,7 @@ std::unique_ptr<writer_t> create_writer(const std::string &type, const po::varia
 #ifdef ENABLE_TBB
 int process_replay_directory(const po::variables_map &vm, const std::string &input, const std::string &output, const std::string &type, bool debug)
 {
-    // load all arena's so we can use manual load parser
-    init_arena_definition();
+    // the arenas are loaded on demand by the parsers, the tanks are used by the draw rules
     init_tank_definition();
 
     auto it = directory_iterator(input);
@@ -215,18 +231,29 @@ int process_replay_directory(const po::variables_map &vm, const std::string &inp
         return "";
     };
 
-    auto f_parse_replay = [](std::string file_name) -> game_t* {
-        std::ifstream in(file_name, std::ios::binary);
+    // the games wait for a writer in the pipeline, keep only the packets used by the writer
+    std::unique_ptr<writer_t> prototype = create_writer(type, vm);
+    if (!prototype) {
+        return EX_SOFTWARE;
+    }
+    std::vector<uint32_t> packet_types = prototype->get_packet_types();
 
-        if (!in) {
+    auto f_parse_replay = [&vm, &packet_types](std::string file_name) -> game_t* {
+        if (!is_regular_file(file_name)) {
             logger.writef(log_level_t::error, "Failed to open file: %1%\n", file_name);
             return nullptr;
         }
 
         std::unique_ptr<game_t> game(new game_t());
-        parser_t parser(load_data_mode_t::manual);
+        parser_t parser(load_data_mode_t::on_demand);
+        parser.set_compact(true, packet_types);
+        // the pipeline already parses multiple replays in parallel
+        parser.set_thread_count(1);
+        if (vm.count("cache") > 0) {
+            parser.set_cache_directory(vm["cache"].as<std::string>());
+        }
         try {
-            parser.parse(in, *game);
+            parser.parse(path(file_name), *game);
         }
         catch (std::exception &e) {
             logger.writef(log_level_t::error, "Failed to parse file (%1%): %2%\n", file_name, e.what());
@@ -301,25 +328,65 @@ int process_replay_directory(const po::variables_map &vm, const std::string &inp
 
     parser_t parser(load_data_mode_t::bulk);
     parser.set_debug(debug);
+    if (vm.count("cache") > 0) {
+        parser.set_cache_directory(vm["cache"].as<std::string>());
+    }
+
+    std::unique_ptr<writer_t> prototype = create_writer(type, vm);
+    if (!prototype) {
+        return EX_SOFTWARE;
+    }
+
+    // streaming writers receive the packets while the replay is parsed, so a replay is never kept in memory completely,
+    // each replay is streamed into its own writer which is merged once the replay is parsed successfully
+    bool streaming = prototype->is_streaming() && dynamic_cast<image_writer_t*>(prototype.get()) != nullptr;
 
     std::map<std::string, std::unique_ptr<writer_t>> writers;
+    auto get_writer = [&](const game_t &game) {
+        std::string name = (boost::format("%s_%s") % game.get_map_name() % game.get_game_mode()).str();
+        auto writer = writers.find(name);
+
+        if (writer == writers.end()) {
+            auto new_writer = create_writer(type, vm);
+            auto result = writers.insert(std::make_pair(name, std::move(new_writer)));
+            writer = result.first;
+            (writer->second)->init(game.get_arena(), game.get_game_mode());
+        }
+
+        return (writer->second).get();
+    };
+
     for (auto it = directory_iterator(input); it != directory_iterator(); ++it) {
         if (!is_regular_file(*it) || it->path().extension() != ".wotreplay") {
             continue;
         }
 
-        std::ifstream in(it->path().string(), std::ios::binary);
-        if (!in) {
-            logger.writef(log_level_t::error, "Failed to open file: %1%\n", it->path().string());
-            return EX_SOFTWARE;
-        }
-
         game_t game;
+        std::unique_ptr<writer_t> replay_writer;
 
         try {
-            parser.parse(in, game);
+            if (streaming) {
+                parser.parse(it->path(), game, [&](const game_t &game, const packet_t &packet) {
+                    // if we can't load arena data, skip this replay
+                    if (game.get_arena().name.empty()) {
+                        return;
+                    }
+
+                    if (!replay_writer) {
+                        replay_writer = create_writer(type, vm);
+                        replay_writer->init(game.get_arena(), game.get_game_mode());
+                        replay_writer->begin(game);
+                    }
+
+                    replay_writer->update(game, packet);
+                });
+            }
+            else {
+                parser.parse(it->path(), game);
+            }
         }
         catch (std::exception &e) {
+            // the packets of a replay which failed to parse are discarded together with its writer
             logger.writef(log_level_t::error, "Failed to parse file (%1%): %2%\n", it->path().string(), e.what());
             continue;
         }
@@ -329,17 +396,13 @@ int process_replay_directory(const po::variables_map &vm, const std::string &inp
             continue;
         }
 
-        std::string name = (boost::format("%s_%s") % game.get_map_name() % game.get_game_mode()).str();
-        auto writer = writers.find(name);
-
-        if (writer == writers.end()) {
-            auto new_writer = create_writer(type, vm);
-            auto result = writers.insert(std::make_pair(name, std::move(new_writer)));
-            writer = result.first;
-            (writer->second)->init(game.get_arena(), game.get_game_mode());
+        if (!streaming) {
+            get_writer(game)->update(game);
+        }
+        else if (replay_writer) {
+            replay_writer->end(game);
+            static_cast<image_writer_t*>(get_writer(game))->merge(static_cast<const image_writer_t&>(*replay_writer));
         }
-
-        (writer->second)->update(game);
     }
 
     for (auto it = writers.begin(); it != writers.end(); ++it) {
@@ -372,8 +435,7 @@ int process_replay_file(const po::variables_map &vm, const std::string &input, c
         return EX_USAGE;
     }
 
-    std::ifstream in(input, std::ios::binary);
-    if (!in) {
+    if (!is_regular_file(input)) {
         logger.writef(log_level_t::error, "Failed to open file: %1%\n", input);
         return EX_SOFTWARE;
     }
@@ -382,21 +444,72 @@ int process_replay_file(const po::variables_map &vm, const std::string &input, c
     game_t game;
 
     parser.set_debug(debug);
-    parser.parse(in, game);
+    // decrypting on a separate thread only pays off with spare cores, leave it to the user
+    if (vm.count("pipelined") > 0) {
+        parser.set_decryption_mode(decryption_mode_t::pipelined);
+    }
+    if (vm.count("cache") > 0) {
+        parser.set_cache_directory(vm["cache"].as<std::string>());
+    }
 
     boost::char_separator<char> sep(",");
     boost::tokenizer<boost::char_separator<char>> tokens(type, sep);
     bool single = std::distance(tokens.begin(), tokens.end()) == 1;
+
+    std::vector<std::unique_ptr<writer_t>> writers;
     for (auto it = tokens.begin(); it != tokens.end(); ++it) {
-        std::unique_ptr<writer_t> writer = create_writer(*it, vm);
+        writers.push_back(create_writer(*it, vm));
 
-        if (!writer) {
+        if (!writers.back()) {
             return EX_SOFTWARE;
         }
+    }
+
+    bool streaming = std::all_of(writers.begin(), writers.end(), [](const std::unique_ptr<writer_t> &writer) {
+        return writer->is_streaming();
+    });
+
+    if (streaming) {
+        // the writers receive the packets while the replay is parsed, the replay is never kept in memory completely
+        bool started = false;
+        auto begin = [&](const game_t &game) {
+            for (auto &writer : writers) {
+                writer->init(game.get_arena(), game.get_game_mode());
+                writer->begin(game);
+            }
+            started = true;
+        };
+
+        parser.parse(path(input), game, [&](const game_t &game, const packet_t &packet) {
+            if (!started) {
+                begin(game);
+            }
+
+            for (auto &writer : writers) {
+                writer->update(game, packet);
+            }
+        });
+
+        if (!started) {
+            begin(game);
+        }
 
-        writer->init(game.get_arena(), game.get_game_mode());
-        writer->update(game);
-        writer->finish();
+        for (auto &writer : writers) {
+            writer->end(game);
+        }
+    }
+    else {
+        parser.parse(path(input), game);
+
+        for (auto &writer : writers) {
+            writer->init(game.get_arena(), game.get_game_mode());
+            writer->update(game);
+        }
+    }
+
+    auto writer = writers.begin();
+    for (auto it = tokens.begin(); it != tokens.end(); ++it, ++writer) {
+        (*writer)->finish();
 
         std::ostream *out;
 
@@ -413,7 +526,7 @@ int process_replay_file(const po::variables_map &vm, const std::string &input, c
             out = &std::cout;
         }
 
-        writer->write(*out);
+        (*writer)->write(*out);
 
         if (dynamic_cast<std::ofstream*>(out)) {
             dynamic_cast<std::ofstream*>(out)->close();
@@ -440,10 +553,13 @@ int main(int argc, const char * argv []) {
         ("output", po::value(&output), "output file or directory")
         ("input", po::value(&input), "input file or directory")
         ("root", po::value(&root), "set root directory")
+        ("cache", po::value<std::string>(), "cache decoded replays in a directory")
+        ("pipelined", "when parsing a single replay, decrypt on a separate thread")
         ("help", "produce help message")
         ("debug", "enable parser debugging")
         ("supress-empty", "supress empty packets from json output")
         ("create-minimaps", "create all empty minimaps in output directory")
+        ("create-catalog", "compile the arena and tank definitions into a catalog (default output catalog.bin)")
         ("parse", "parse a replay file")
         ("quiet", "supress diagnostic messages")
         ("skip", po::value(&skip)->default_value(60., "60"), "for heatmaps, skip a certain number of seconds after the start of the battle")
@@ -524,6 +640,10 @@ int main(int argc, const char * argv []) {
         // create all minimaps
         exit_code = create_minimaps(vm, output, debug);
     }
+    else if (vm.count("create-catalog") > 0) {
+        // compile the definitions into a catalog
+        exit_code = create_catalog(vm, output);
+    }
     else {
         logger.write(wotreplay::log_level_t::error, "Error: no mode specified\n");
         exit_code = EX_USAGE;
@@ -26,11 +26,10 @@ MainWindow::~MainWindow()
 }
 
 std::unique_ptr<image_writer_t> MainWindow::create_writer(const std::string &path) const {
-	std::ifstream in(path, std::ios::binary);
 	parser_t parser;
 
 	game_t game;
-	parser.parse(in, game);
+	parser.parse(boost::filesystem::path(path), game);
 
 	std::string type = ui->typeComboBox->currentText().toUtf8().constData();
 
@@ -1,4 +1,5 @@
 #include "packet.h"
+#include "packet_schema.h"
 
 #include <boost/format.hpp>
 #include <sstream>
@@ -9,34 +10,42 @@ packet_t::packet_t(const slice_t &data) {
     this->set_data(data);
 }
 
+packet_t::packet_t(const slice_t &data, property_mask_t properties)
+    : properties(properties), data(data)
+{
+    // empty
+}
+
 uint32_t packet_t::type() const {
     assert(has_property(property_t::type));
-    return get_field<uint32_t>(data.begin(), data.end(), 4);
+    return get_field<uint32_t>(data.begin(), data.end(), schema_offset(any_packet_type, any_sub_type, property_t::type));
 }
 
 uint32_t packet_t::player_id() const {
     assert(has_property(property_t::player_id));
-    return get_field<uint32_t>(data.begin(), data.end(), 12);
+    return get_field<uint32_t>(data.begin(), data.end(), offset(property_t::player_id));
 }
 
 float packet_t::clock() const {
     assert(has_property(property_t::clock));
-    return get_field<float>(data.begin(), data.end(), 8);
+    return get_field<float>(data.begin(), data.end(), offset(property_t::clock));
 }
 
 std::tuple<float, float, float> packet_t::position() const {
-    assert(type() == 0x0A);
-    float x = get_field<float>(data.begin(), data.end(), 20);
-    float y = get_field<float>(data.begin(), data.end(), 24);
-    float z = get_field<float>(data.begin(), data.end(), 28);
+    assert(has_property(property_t::position));
+    size_t pos = offset(property_t::position);
+    float x = get_field<float>(data.begin(), data.end(), pos);
+    float y = get_field<float>(data.begin(), data.end(), pos + 4);
+    float z = get_field<float>(data.begin(), data.end(), pos + 8);
     return std::make_tuple(x,y,z);
 }
 
 std::tuple<float, float, float> packet_t::hull_orientation() const {
     assert(has_property(property_t::hull_orientation));
-    float x = get_field<float>(data.begin(), data.end(), 48);
-    float y = get_field<float>(data.begin(), data.end(), 52);
-    float z = get_field<float>(data.begin(), data.end(), 56);
+    size_t pos = offset(property_t::hull_orientation);
+    float x = get_field<float>(data.begin(), data.end(), pos);
+    float y = get_field<float>(data.begin(), data.end(), pos + 4);
+    float z = get_field<float>(data.begin(), data.end(), pos + 8);
     return std::make_tuple(x,y,z);
 }
 
@@ -47,124 +56,82 @@ float packet_t::turret_orientation() const {
 
 uint16_t packet_t::health() const {
     assert(has_property(property_t::health));
-    return get_field<uint16_t>(data.begin(), data.end(), 24);
+    return get_field<uint16_t>(data.begin(), data.end(), offset(property_t::health));
+}
+
+std::array<bool, static_cast<size_t>(property_t::property_nr_items)> packet_t::get_properties() const {
+    std::array<bool, static_cast<size_t>(property_t::property_nr_items)> result;
+    for (size_t p = 0; p < result.size(); ++p) {
+        result[p] = (properties >> p) & 1;
+    }
+    return result;
 }
 
-const std::array<bool, static_cast<size_t>(property_t::property_nr_items)> &packet_t::get_properties() const {
+property_mask_t packet_t::get_property_mask() const {
     return properties;
 }
 
 bool packet_t::has_property(property_t p) const {
-    return properties[static_cast<size_t>(p)];
+    return (properties >> static_cast<size_t>(p)) & 1;
+}
+
+void packet_t::set_property(property_t p, bool value) {
+    if (value) {
+        properties |= property_mask_t(1) << static_cast<size_t>(p);
+    } else {
+        properties &= ~(property_mask_t(1) << static_cast<size_t>(p));
+    }
 }
 
 void packet_t::set_data(const slice_t &data) {
     this->data = data;
 
-    // reset all properties
-    std::fill(properties.begin(), properties.end(), false);
-
-    // enable default properties
-    properties[static_cast<size_t>(property_t::type)] = true;
-    properties[static_cast<size_t>(property_t::length)] = true;
-    
-    switch(get_field<uint32_t>(data.begin(), data.end(), 4)) {
-        case 0x03:
-        case 0x05:
-            properties[static_cast<size_t>(property_t::clock)] = true;
-            properties[static_cast<size_t>(property_t::player_id)] = true;
-            break;
-        case 0x0a:
-            properties[static_cast<size_t>(property_t::position)] = true;
-            properties[static_cast<size_t>(property_t::hull_orientation)] = true;
-            properties[static_cast<size_t>(property_t::clock)] = true;
-            properties[static_cast<size_t>(property_t::player_id)] = true;
-            break;
-        case 0x07: {
-            properties[static_cast<size_t>(property_t::clock)] = true;
-            properties[static_cast<size_t>(property_t::player_id)] = true;
-            properties[static_cast<size_t>(property_t::sub_type)] = true;
-            properties[static_cast<size_t>(property_t::health)] = sub_type() == 0x05;
-            properties[static_cast<size_t>(property_t::destroyed_track_id)] = sub_type() == 0x07;
-            break;
+    uint32_t type = get_field<uint32_t>(data.begin(), data.end(), schema_offset(any_packet_type, any_sub_type, property_t::type));
+    const packet_layout_t &layout = get_packet_layout(type);
+    properties = layout.properties;
+
+    if (layout.conditional_begin == layout.conditional_end) {
+        return;
+    }
+
+    uint32_t sub_type = has_property(property_t::sub_type) ? this->sub_type() : any_sub_type;
+    for (size_t ix = layout.conditional_begin; ix < layout.conditional_end; ++ix) {
+        const field_schema_t &field = packet_schema[ix];
+        if ((field.sub_type == any_sub_type || field.sub_type == sub_type) &&
+            data.size() >= field.min_size &&
+            (field.signature_offset == 0 ||
+             get_field<uint32_t>(data.begin(), data.end(), field.signature_offset) == field.signature)) {
+            set_property(field.property, true);
         }
-        case 0x08: {
-            if (data.size() >= 28) {
-                auto signature = get_field<uint32_t>(data.begin(), data.end(), 24);
-                properties[static_cast<size_t>(property_t::tank_destroyed)] = 0x02801306 == signature;
-            }
-            properties[static_cast<size_t>(property_t::clock)] = true;
-            properties[static_cast<size_t>(property_t::player_id)] = true;
-            properties[static_cast<size_t>(property_t::sub_type)] = true;
-            switch (this->sub_type()) {
-                case 0x01:
-                    properties[static_cast<size_t>(property_t::source)] = true;
-                    properties[static_cast<size_t>(property_t::health)] = true;
-                case 0x02:
-                    // < 8.5
-                    // properties[static_cast<size_t>(property_t::health)] = true;
-                    // properties[static_cast<size_t>(property_t::source)] = true;
-                    break;
-                case 0x05:
-                    // hit
-                    properties[static_cast<size_t>(property_t::source)] = true;
-                    break;
-                case 0x0B:
-                    // module damage
-                    properties[static_cast<size_t>(property_t::source)] = true;
-                    properties[static_cast<size_t>(property_t::target)] = true;
-                    break;
-                case 0x11:
-                    // tracer information
-                    break;
-                case 0x17:
-                    // tracked ?
-                    properties[static_cast<size_t>(property_t::target)] = true;
-                    break;
-                case 0x19:
-                    // related to tank destroyed
-                    break;
-                case 0x1d:
-                    break;
+    }
+}
+
+size_t packet_t::offset(property_t p) const {
+    const packet_layout_t &layout = get_packet_layout(type());
+    if ((layout.sub_type_properties >> static_cast<size_t>(p)) & 1) {
+        uint32_t sub_type = this->sub_type();
+        for (size_t ix = layout.conditional_begin; ix < layout.conditional_end; ++ix) {
+            const field_schema_t &field = packet_schema[ix];
+            if (field.property == p && field.sub_type == sub_type) {
+                return field.offset;
             }
-            break;
-        }
-        case 0x23: {
-            properties[static_cast<size_t>(property_t::clock)] = true;
-            properties[static_cast<size_t>(property_t::message)] = true;
-            break;
-        }
-        case 0x20: {
-            properties[static_cast<size_t>(property_t::clock)] = true;
-            properties[static_cast<size_t>(property_t::player_id)] = true;
-            break;
-        }
-        default: {
-            properties[static_cast<size_t>(property_t::clock)] = data.size() >= 13;
-            break;
         }
     }
+    return layout.offsets[static_cast<size_t>(p)];
 }
 
 uint32_t packet_t::sub_type() const {
     assert(has_property(property_t::sub_type));
-    return get_field<uint32_t>(data.begin(), data.end(), 16);
+    return get_field<uint32_t>(data.begin(), data.end(), offset(property_t::sub_type));
 }
 
 uint8_t packet_t::destroyed_track_id() const {
     assert(has_property(property_t::destroyed_track_id));
-    uint8_t destroyed_track_id = 0;
-    switch(type()) {
-        case 0x07:
-            if (get_field<uint32_t>(data.begin(), data.end(), 20) == 5) {
-                destroyed_track_id = get_field<uint8_t>(data.begin(), data.end(), 28);
-            }
-            break;
-        case 0x20:
-            destroyed_track_id = get_field<uint8_t>(data.begin(), data.end(), 22);
-            break;
+    // the track id is only valid when the value at offset 20 is 5
+    if (get_field<uint32_t>(data.begin(), data.end(), 20) != 5) {
+        return 0;
     }
-    return destroyed_track_id;
+    return get_field<uint8_t>(data.begin(), data.end(), offset(property_t::destroyed_track_id));
 }
 
 uint8_t packet_t::alt_track_state() const {
@@ -174,25 +141,12 @@ uint8_t packet_t::alt_track_state() const {
 
 uint32_t packet_t::source() const {
     assert(has_property(property_t::source));
-    int pos;
-    switch (sub_type()) {
-        case 0x01:
-            pos = 26;
-            break;
-        case 0x0B:
-            pos = 30;
-            break;
-        default:
-            pos = 24;
-            break;
-    }
-    return get_field<uint32_t>(data.begin(), data.end(), pos);
+    return get_field<uint32_t>(data.begin(), data.end(), offset(property_t::source));
 }
 
 uint32_t packet_t::target() const {
     assert(has_property(property_t::target));
-    int pos = (sub_type() == 0x17) ? 28 : 24;
-    return get_field<uint32_t>(data.begin(), data.end(), pos);
+    return get_field<uint32_t>(data.begin(), data.end(), offset(property_t::target));
 }
 
 const slice_t &packet_t::get_data() const {
@@ -201,21 +155,24 @@ const slice_t &packet_t::get_data() const {
 
 std::tuple<uint32_t, uint32_t, uint8_t> packet_t::tank_destroyed() const {
     assert(has_property(property_t::tank_destroyed));
+    size_t pos = offset(property_t::tank_destroyed);
     return std::make_tuple(
-        get_field<uint32_t>(data.begin(), data.end(), 30),
-        get_field<uint32_t>(data.begin(), data.end(), 35),
-        get_field<uint8_t>(data.begin(), data.end(), 42)
+        get_field<uint32_t>(data.begin(), data.end(), pos),
+        get_field<uint32_t>(data.begin(), data.end(), pos + 5),
+        get_field<uint8_t>(data.begin(), data.end(), pos + 12)
     );
 }
 
 std::string packet_t::message() const {
-    size_t field_size = get_field<uint32_t>(data.begin(), data.end(), 12);
-    return std::string(data.begin() + 16, data.begin() + 16 + field_size);
+    assert(has_property(property_t::message));
+    size_t pos = offset(property_t::message);
+    size_t field_size = get_field<uint32_t>(data.begin(), data.end(), pos);
+    return std::string(data.begin() + pos + 4, data.begin() + pos + 4 + field_size);
 }
 
 uint32_t packet_t::length() const {
     assert(has_property(property_t::length));
-    return get_field<uint32_t>(data.begin(), data.end(), 0);
+    return get_field<uint32_t>(data.begin(), data.end(), offset(property_t::length));
 }
 
 std::ostream& wotreplay::operator<<(std::ostream& os, const packet_t &packet) {
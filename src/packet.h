@@ -36,6 +36,14 @@ namespace wotreplay {
         property_nr_items
     };
 
+    /**
+     * @typedef uint32_t wotreplay::property_mask_t
+     * @brief A set of properties, property p is present when bit (1 << p) is set.
+     */
+    typedef uint32_t property_mask_t;
+
+    static_assert(property_t::property_nr_items <= sizeof(property_mask_t) * 8, "property_mask_t too small");
+
     /**
      * A representation of a single packet in a World Of Tanks replay. This
      * class provides easy accessor methods to determine the properties of packet,
@@ -52,6 +60,12 @@ namespace wotreplay {
          * @param data The content of this packet.
          */
         packet_t(const slice_t &data);
+        /**
+         * Constructor for a packet with defined content, of which the properties are already known.
+         * @param data The content of this packet.
+         * @param properties The properties of this packet, as returned by get_property_mask().
+         */
+        packet_t(const slice_t &data, property_mask_t properties);
         /** total packet payload length */
         uint32_t length() const;
         /** @return The packet type */
@@ -75,7 +89,9 @@ namespace wotreplay {
         /** @return A tuple of with the player_id's of the target and the killer. */
         std::tuple<uint32_t, uint32_t, uint8_t> tank_destroyed() const;
         /** @return An array of the properties available in this packet. */
-        const std::array<bool, static_cast<size_t>(property_t::property_nr_items)> &get_properties() const;
+        std::array<bool, static_cast<size_t>(property_t::property_nr_items)> get_properties() const;
+        /** @return The set of properties available in this packet. */
+        property_mask_t get_property_mask() const;
         /**
          * Determines if the packet has the property specified.
          * @param p The property
@@ -129,8 +145,20 @@ namespace wotreplay {
          */
         uint8_t alt_track_state() const;
     private:
-        /** An array containing the presence of each property. */
-        std::array<bool, static_cast<size_t>(property_t::property_nr_items)> properties;
+        /**
+         * Determines the offset of the field of a property, see wotreplay::packet_schema.
+         * @param p The property, it should be present in this packet
+         * @return The offset of the field in the data of this packet
+         */
+        size_t offset(property_t p) const;
+        /**
+         * Sets the presence of a property.
+         * @param p The property
+         * @param value \c true if the packet contains the property
+         */
+        void set_property(property_t p, bool value);
+        /** The presence of each property. */
+        property_mask_t properties = 0;
         /** The data content of this packet. */
         slice_t data;
     };
@@ -0,0 +1,46 @@
+#include "packet_cursor.h"
+
+#include <algorithm>
+
+using namespace wotreplay;
+
+packet_cursor_t::packet_cursor_t(const game_t &game)
+    : packet_cursor_t(game, std::vector<uint32_t>())
+{
+    // empty
+}
+
+packet_cursor_t::packet_cursor_t(const game_t &game, std::vector<uint32_t> types)
+    : game(game), reader(create_packet_reader(game.get_version())), types(std::move(types))
+{
+    reader->init(game.get_version(), &game.get_raw_replay(), game.get_game_title());
+}
+
+bool packet_cursor_t::next() {
+    if (game.get_raw_replay().empty()) {
+        return false;
+    }
+
+    while (reader->has_next()) {
+        if (accept(reader->next_type())) {
+            current = reader->next();
+            return true;
+        }
+
+        reader->skip();
+    }
+
+    return false;
+}
+
+const packet_t &packet_cursor_t::packet() const {
+    return current;
+}
+
+size_t packet_cursor_t::offset() const {
+    return current.get_data().begin() - game.get_raw_replay().data();
+}
+
+bool packet_cursor_t::accept(uint32_t type) const {
+    return types.empty() || std::find(types.begin(), types.end(), type) != types.end();
+}
@@ -0,0 +1,63 @@
+#ifndef wotreplay_packet_cursor_h
+#define wotreplay_packet_cursor_h
+
+#include "game.h"
+#include "packet.h"
+#include "packet_reader.h"
+
+#include <memory>
+#include <vector>
+
+/** @file */
+
+namespace wotreplay {
+    /**
+     * wotreplay::packet_cursor_t is a forward cursor over the packets of a game. The packets are read
+     * from the decompressed replay when the cursor advances, packets which are filtered out by type
+     * are skipped without being read.
+     *
+     * Example:
+     * \code
+     * packet_cursor_t cursor(game, { 0x0a });
+     * while (cursor.next()) {
+     *     auto position = cursor.packet().position();
+     * }
+     * \endcode
+     */
+    class packet_cursor_t {
+    public:
+        /**
+         * Create a cursor over all the packets of the game
+         * @param game The game, it should outlive the cursor
+         */
+        explicit packet_cursor_t(const game_t &game);
+        /**
+         * Create a cursor over the packets of the game with one of the given types
+         * @param game The game, it should outlive the cursor
+         * @param types The packet types to include
+         */
+        packet_cursor_t(const game_t &game, std::vector<uint32_t> types);
+        /**
+         * Advances the cursor to the next packet
+         * @return \c true if the cursor points to a packet, \c false if there are no more packets
+         */
+        bool next();
+        /**
+         * @return The current packet, only valid after next() returned \c true
+         */
+        const packet_t &packet() const;
+        /**
+         * @return The offset of the current packet in the decompressed replay
+         */
+        size_t offset() const;
+    private:
+        /** @return \c true if a packet with the given type is included */
+        bool accept(uint32_t type) const;
+        const game_t &game;
+        std::unique_ptr<packet_reader_t> reader;
+        std::vector<uint32_t> types;
+        packet_t current;
+    };
+}
+
+#endif /* defined(wotreplay_packet_cursor_h) */
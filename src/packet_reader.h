@@ -4,6 +4,8 @@
 #include "game.h"
 #include "types.h"
 
+#include <memory>
+
 namespace wotreplay {
 	class packet_t;
 
@@ -23,6 +25,30 @@ namespace wotreplay {
          * @return \c true if there is a next packet available \c false if there is no such packet
          */
         virtual bool has_next() = 0;
+        /**
+         * Determines the type of the next packet in the buffer without reading the packet, expects
+         * that there is a new packet available.
+         * @return the type of the next packet in the buffer
+         */
+        virtual uint32_t next_type() = 0;
+        /**
+         * Skips the next packet in the buffer without reading it, expects that there is a new packet
+         * available.
+         */
+        virtual void skip() = 0;
+        /**
+         * Reads the packet at the start of the window [begin, end), used to read packets from a
+         * stream instead of a complete buffer.
+         * @param begin start of the window
+         * @param end end of the window
+         * @param packet output variable for the packet, it refers to the window
+         * @return \c true if the window contains the complete packet \c false if more data is required
+         */
+        virtual bool next(const uint8_t *begin, const uint8_t *end, packet_t &packet) = 0;
+        /**
+         * Signals all packets of the buffer or the stream have been read, validates the last packet
+         */
+        virtual void end() = 0;
         /**
          * Determines if the reader is compatible with the given version
          * @param version the game version of the replay buffer
@@ -32,11 +58,19 @@ namespace wotreplay {
         /**
          * Initializes the packet reader
          * @param version the game version of the replay buffer
-         * @param buffer the replay buffer
+         * @param buffer the replay buffer, \c nullptr if the replay is read as a stream
          */
-        virtual void init(const version_t &version, buffer_t *buffer, game_title_t title) = 0;
+        virtual void init(const version_t &version, const buffer_t *buffer, game_title_t title) = 0;
         virtual ~packet_reader_t() {}
     };
+
+    /**
+     * Creates the packet reader for a game version. There is a single reader (packet_reader_80_t), the
+     * version is not used yet to select one.
+     * @param version the game version of the replay buffer
+     * @return the packet reader, it may not be compatible with version
+     */
+    std::unique_ptr<packet_reader_t> create_packet_reader(const version_t &version);
 }
 
 #endif /* defined(wotreplay_packet_reader_h) */
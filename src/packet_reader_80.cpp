@@ -5,49 +5,95 @@
 
 using namespace wotreplay;
 
-void packet_reader_80_t::init(const version_t &version, buffer_t *buffer, game_title_t title) {
+void packet_reader_80_t::init(const version_t &version, const buffer_t *buffer, game_title_t title) {
     this->buffer = buffer;
     this->version = version;
     this->pos = 0;
+    this->last_type = 0;
 	this->title = title;
 }
 
 
-packet_t packet_reader_80_t::next() {
+std::unique_ptr<packet_reader_t> wotreplay::create_packet_reader(const version_t &) {
+    // the only reader, older versions are rejected by is_compatible
+    return std::unique_ptr<packet_reader_t>(new packet_reader_80_t());
+}
+
+int packet_reader_80_t::next_size() const {
     const int base_packet_size = 12;
-    int payload_size = *reinterpret_cast<int*>(&((*buffer)[pos]));
+    int payload_size = *reinterpret_cast<const int*>(&((*buffer)[pos]));
     int packet_size = payload_size + base_packet_size;
     
     if ((pos + packet_size) > buffer->size()) {
         throw std::runtime_error("packet outside of bounds");
     }
 
-    auto packet_begin = buffer->begin() + pos;
-    auto packet_end = packet_begin + packet_size;
+    return packet_size;
+}
+
+packet_t packet_reader_80_t::next() {
+    int packet_size = next_size();
+
+    const uint8_t *packet_begin = buffer->data() + pos;
+    const uint8_t *packet_end = packet_begin + packet_size;
 
     packet_t packet( boost::make_iterator_range(packet_begin, packet_end) );
     logger.writef(wotreplay::log_level_t::debug,
                     "[%2%] type=0x%1$02X size=%3%\n%4%\n",
                     packet.type(), pos, packet_size, packet);
     
-    prev = pos;
+    last_type = packet.type();
     pos += packet_size;
     
     return packet;
 }
 
 bool packet_reader_80_t::has_next() {
-    bool has_next = pos < buffer->size();
-    if (!has_next) {
-        // check if we ended with an end marker type block
-        const int end_marker = 0xFFFFFFFF;
-        int type = *(reinterpret_cast<int*>(&((*buffer)[prev])) + 1);
-        if (type != end_marker) {
-            logger.write(log_level_t::warning, "packet stream did not end with end marker type block\n");
-        }
-    
+    return pos < buffer->size();
+}
+
+uint32_t packet_reader_80_t::next_type() {
+    return get_field<uint32_t>(buffer->data() + pos, buffer->data() + pos + next_size(), 4);
+}
+
+void packet_reader_80_t::skip() {
+    int packet_size = next_size();
+    last_type = get_field<uint32_t>(buffer->data() + pos, buffer->data() + pos + packet_size, 4);
+    pos += packet_size;
+}
+
+bool packet_reader_80_t::next(const uint8_t *begin, const uint8_t *end, packet_t &packet) {
+    const size_t base_packet_size = 12;
+    if (end - begin < base_packet_size) {
+        return false;
+    }
+
+    size_t packet_size = get_field<uint32_t>(begin, end, 0) + base_packet_size;
+    if (end - begin < packet_size) {
+        return false;
+    }
+
+    packet.set_data(boost::make_iterator_range(begin, begin + packet_size));
+    logger.writef(wotreplay::log_level_t::debug,
+                    "[%2%] type=0x%1$02X size=%3%\n%4%\n",
+                    packet.type(), pos, packet_size, packet);
+
+    last_type = packet.type();
+    pos += packet_size;
+
+    return true;
+}
+
+void packet_reader_80_t::end() {
+    check_end_marker(last_type);
+}
+
+void packet_reader_80_t::check_end_marker(uint32_t type) const {
+    // check if we ended with an end marker type block
+    const uint32_t end_marker = 0xFFFFFFFF;
+    if (type != end_marker) {
+        logger.write(log_level_t::warning, "packet stream did not end with end marker type block\n");
     }
-    return has_next;
 }
 
 bool packet_reader_80_t::is_compatible(const version_t &version) {
@@ -25,14 +25,29 @@ namespace wotreplay {
      */
     class packet_reader_80_t : public packet_reader_t {
     public:
-        virtual void init(const version_t &version, buffer_t *buffer, game_title_t title);
+        virtual void init(const version_t &version, const buffer_t *buffer, game_title_t title);
         virtual packet_t next();
         virtual bool has_next();
+        virtual uint32_t next_type();
+        virtual void skip();
+        virtual bool next(const uint8_t *begin, const uint8_t *end, packet_t &packet);
+        virtual void end();
         virtual bool is_compatible(const version_t &version);
     private:
-        buffer_t *buffer;
+        /**
+         * Warns if the packet stream did not end with an end marker type block
+         * @param type the type of the last packet
+         */
+        void check_end_marker(uint32_t type) const;
+        /**
+         * Determines the size of the next packet in the buffer
+         * @return the size of the next packet
+         */
+        int next_size() const;
+        const buffer_t *buffer;
         version_t version;
-        int pos, prev;
+        int pos;
+        uint32_t last_type;
 		game_title_t title;
     };
 }
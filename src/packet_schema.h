@@ -0,0 +1,248 @@
+#ifndef wotreplay_packet_schema_h
+#define wotreplay_packet_schema_h
+
+#include "packet.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @file */
+
+namespace wotreplay {
+    /** Packet type of the fields present in all packets */
+    constexpr uint32_t any_packet_type = 0xFFFFFFFE;
+    /** Packet type of the fields present in the packets of which the type is not in the schema */
+    constexpr uint32_t unknown_packet_type = 0xFFFFFFFD;
+    /** Sub type of the fields present independent of the sub type */
+    constexpr uint32_t any_sub_type = 0xFFFFFFFF;
+    /** Number of packet types with a precomputed layout, other types use the layout of unknown_packet_type */
+    constexpr uint32_t packet_type_count = 0x40;
+
+    /**
+     * Describes a field of a packet: the property it provides, where it is located and when it
+     * is present.
+     */
+    struct field_schema_t {
+        /** packet type containing the field */
+        uint32_t type;
+        /** sub type containing the field, or any_sub_type */
+        uint32_t sub_type;
+        /** property provided by the field */
+        property_t property;
+        /** offset of the field in the packet */
+        uint8_t offset;
+        /** the field is only present in packets of at least this size */
+        uint8_t min_size;
+        /** the field is only present if the uint32_t at this offset equals signature, 0 to disable */
+        uint8_t signature_offset;
+        uint32_t signature;
+    };
+
+    /**
+     * The fields of the packets, the fields of a packet type should be listed together. Packet
+     * classification and the accessors of wotreplay::packet_t are derived from this table.
+     */
+    constexpr field_schema_t packet_schema[] = {
+        // type               sub_type      property                        offset  min_size  signature
+        { any_packet_type,     any_sub_type, property_t::length,             0,      0,        0, 0 },
+        { any_packet_type,     any_sub_type, property_t::type,               4,      0,        0, 0 },
+        { unknown_packet_type, any_sub_type, property_t::clock,              8,      13,       0, 0 },
+        { 0x03,                any_sub_type, property_t::clock,              8,      0,        0, 0 },
+        { 0x03,                any_sub_type, property_t::player_id,          12,     0,        0, 0 },
+        { 0x05,                any_sub_type, property_t::clock,              8,      0,        0, 0 },
+        { 0x05,                any_sub_type, property_t::player_id,          12,     0,        0, 0 },
+        { 0x07,                any_sub_type, property_t::clock,              8,      0,        0, 0 },
+        { 0x07,                any_sub_type, property_t::player_id,          12,     0,        0, 0 },
+        { 0x07,                any_sub_type, property_t::sub_type,           16,     0,        0, 0 },
+        { 0x07,                0x05,         property_t::health,             24,     0,        0, 0 },
+        { 0x07,                0x07,         property_t::destroyed_track_id, 28,     0,        0, 0 },
+        { 0x08,                any_sub_type, property_t::clock,              8,      0,        0, 0 },
+        { 0x08,                any_sub_type, property_t::player_id,          12,     0,        0, 0 },
+        { 0x08,                any_sub_type, property_t::sub_type,           16,     0,        0, 0 },
+        { 0x08,                any_sub_type, property_t::tank_destroyed,     30,     28,       24, 0x02801306 },
+        { 0x08,                0x01,         property_t::health,             24,     0,        0, 0 },
+        { 0x08,                0x01,         property_t::source,             26,     0,        0, 0 },
+        { 0x08,                0x05,         property_t::source,             24,     0,        0, 0 },
+        { 0x08,                0x0B,         property_t::source,             30,     0,        0, 0 },
+        { 0x08,                0x0B,         property_t::target,             24,     0,        0, 0 },
+        { 0x08,                0x17,         property_t::target,             28,     0,        0, 0 },
+        { 0x0a,                any_sub_type, property_t::clock,              8,      0,        0, 0 },
+        { 0x0a,                any_sub_type, property_t::player_id,          12,     0,        0, 0 },
+        { 0x0a,                any_sub_type, property_t::position,           20,     0,        0, 0 },
+        { 0x0a,                any_sub_type, property_t::hull_orientation,   48,     0,        0, 0 },
+        { 0x20,                any_sub_type, property_t::clock,              8,      0,        0, 0 },
+        { 0x20,                any_sub_type, property_t::player_id,          12,     0,        0, 0 },
+        { 0x23,                any_sub_type, property_t::clock,              8,      0,        0, 0 },
+        { 0x23,                any_sub_type, property_t::message,            12,     0,        0, 0 },
+    };
+
+    /** number of fields in the schema */
+    constexpr size_t packet_schema_size = sizeof(packet_schema) / sizeof(packet_schema[0]);
+
+    /** @return \c true if the schema contains fields for the packet type */
+    constexpr bool schema_has_type(uint32_t type, size_t ix = 0) {
+        return ix < packet_schema_size && (packet_schema[ix].type == type || schema_has_type(type, ix + 1));
+    }
+
+    /** @return the type of which the fields apply to packets of the given type */
+    constexpr uint32_t schema_type(uint32_t type) {
+        return schema_has_type(type) ? type : unknown_packet_type;
+    }
+
+    /** @return \c true if the presence of the field depends on the contents of the packet */
+    constexpr bool is_conditional(const field_schema_t &field) {
+        return field.sub_type != any_sub_type || field.min_size != 0 || field.signature_offset != 0;
+    }
+
+    /**
+     * @return \c true if the field applies to packets of the given type
+     * @param type packet type as returned by schema_type
+     */
+    constexpr bool applies_to(const field_schema_t &field, uint32_t type) {
+        return field.type == any_packet_type || field.type == type;
+    }
+
+    /**
+     * @return the properties present in all packets of the given type
+     * @param type packet type as returned by schema_type
+     */
+    constexpr property_mask_t schema_properties(uint32_t type, size_t ix = 0) {
+        return ix == packet_schema_size ? 0 :
+            ((applies_to(packet_schema[ix], type) && !is_conditional(packet_schema[ix])) ?
+                property_mask_t(1) << packet_schema[ix].property : 0) | schema_properties(type, ix + 1);
+    }
+
+    /**
+     * @return the properties of which the field depends on the sub type
+     * @param type packet type as returned by schema_type
+     */
+    constexpr property_mask_t schema_sub_type_properties(uint32_t type, size_t ix = 0) {
+        return ix == packet_schema_size ? 0 :
+            ((applies_to(packet_schema[ix], type) && packet_schema[ix].sub_type != any_sub_type) ?
+                property_mask_t(1) << packet_schema[ix].property : 0) | schema_sub_type_properties(type, ix + 1);
+    }
+
+    /**
+     * @return the offset of the field of a property, 0 if the schema does not contain the field
+     * @param type packet type as returned by schema_type
+     */
+    constexpr uint8_t schema_field_offset(uint32_t type, uint32_t sub_type, property_t property, size_t ix = 0) {
+        return ix == packet_schema_size ? 0 :
+            (applies_to(packet_schema[ix], type) && packet_schema[ix].property == property &&
+             (packet_schema[ix].sub_type == any_sub_type || packet_schema[ix].sub_type == sub_type)) ?
+                packet_schema[ix].offset : schema_field_offset(type, sub_type, property, ix + 1);
+    }
+
+    /**
+     * @return the offset of the field of a property in packets of the given type and sub type, 0
+     * if the schema does not contain the field
+     */
+    constexpr uint8_t schema_offset(uint32_t type, uint32_t sub_type, property_t property) {
+        return schema_field_offset(schema_type(type), sub_type, property);
+    }
+
+    /**
+     * @return index of the first conditional field of the packet type
+     * @param type packet type as returned by schema_type
+     */
+    constexpr size_t schema_conditional_begin(uint32_t type, size_t ix = 0) {
+        return (ix == packet_schema_size || (applies_to(packet_schema[ix], type) && is_conditional(packet_schema[ix]))) ?
+            ix : schema_conditional_begin(type, ix + 1);
+    }
+
+    /**
+     * @return index past the last conditional field of the packet type
+     * @param type packet type as returned by schema_type
+     */
+    constexpr size_t schema_conditional_end(uint32_t type, size_t ix = packet_schema_size) {
+        return (ix == 0 || (applies_to(packet_schema[ix - 1], type) && is_conditional(packet_schema[ix - 1]))) ?
+            ix : schema_conditional_end(type, ix - 1);
+    }
+
+    /** @return \c true if the schema contains fields for the packet type before index end */
+    constexpr bool schema_has_type_before(uint32_t type, size_t end, size_t ix = 0) {
+        return ix < end && (packet_schema[ix].type == type || schema_has_type_before(type, end, ix + 1));
+    }
+
+    /** @return \c true if the fields of the packet types are listed together in the schema */
+    constexpr bool schema_is_grouped(size_t ix = 1) {
+        return ix >= packet_schema_size ? true :
+            (packet_schema[ix - 1].type == packet_schema[ix].type ||
+             !schema_has_type_before(packet_schema[ix].type, ix - 1)) && schema_is_grouped(ix + 1);
+    }
+
+    /** @return \c true if the fields of any_packet_type are not conditional, and the types fit in the layout table */
+    constexpr bool schema_is_valid(size_t ix = 0) {
+        return ix == packet_schema_size ? true :
+            (packet_schema[ix].type == any_packet_type ? !is_conditional(packet_schema[ix]) :
+             packet_schema[ix].type == unknown_packet_type || packet_schema[ix].type < packet_type_count) &&
+                schema_is_valid(ix + 1);
+    }
+
+    static_assert(schema_is_grouped(), "fields of a packet type should be listed together in packet_schema");
+    static_assert(schema_is_valid(), "invalid field in packet_schema");
+
+    /**
+     * The layout of a packet type, derived from the schema at compile time.
+     */
+    struct packet_layout_t {
+        /** properties present in all packets of the type */
+        property_mask_t properties;
+        /** properties of which the field depends on the sub type */
+        property_mask_t sub_type_properties;
+        /** offset of the fields independent of the sub type, indexed by property */
+        uint8_t offsets[property_t::property_nr_items];
+        /** range of the conditional fields in the schema */
+        uint8_t conditional_begin;
+        uint8_t conditional_end;
+    };
+
+    /** @cond */
+    template <size_t... ix>
+    struct index_sequence_t {};
+
+    template <size_t n, size_t... ix>
+    struct make_index_sequence_t : make_index_sequence_t<n - 1, n - 1, ix...> {};
+
+    template <size_t... ix>
+    struct make_index_sequence_t<0, ix...> {
+        typedef index_sequence_t<ix...> type;
+    };
+
+    /** @param type packet type as returned by schema_type */
+    template <size_t... properties>
+    constexpr packet_layout_t make_packet_layout(uint32_t type, index_sequence_t<properties...>) {
+        return packet_layout_t {
+            schema_properties(type),
+            schema_sub_type_properties(type),
+            { schema_offset(type, any_sub_type, static_cast<property_t>(properties))... },
+            static_cast<uint8_t>(schema_conditional_begin(type)),
+            static_cast<uint8_t>(schema_conditional_end(type))
+        };
+    }
+
+    template <typename types>
+    struct packet_layout_table_t;
+
+    template <size_t... types>
+    struct packet_layout_table_t<index_sequence_t<types...>> {
+        static constexpr packet_layout_t layouts[] = {
+            make_packet_layout(schema_type(types < packet_type_count ? types : unknown_packet_type),
+                               make_index_sequence_t<property_t::property_nr_items>::type())...
+        };
+    };
+
+    template <size_t... types>
+    constexpr packet_layout_t packet_layout_table_t<index_sequence_t<types...>>::layouts[];
+    /** @endcond */
+
+    /**
+     * @return The layout of the packets of the given type
+     */
+    inline const packet_layout_t &get_packet_layout(uint32_t type) {
+        typedef packet_layout_table_t<make_index_sequence_t<packet_type_count + 1>::type> table_t;
+        return table_t::layouts[type < packet_type_count ? type : packet_type_count];
+    }
+}
+
+#endif /* defined(wotreplay_packet_schema_h) */
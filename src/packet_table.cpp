@@ -0,0 +1,66 @@
+#include "packet_table.h"
+
+#include <cassert>
+
+using namespace wotreplay;
+
+void packet_table_t::push_back(const packet_t &packet, uint32_t offset) {
+    const slice_t &data = packet.get_data();
+
+    type_column.push_back(packet.type());
+    float clock = clock_column.empty() ? 0.f : clock_column.back();
+    clock_column.push_back(packet.has_property(property_t::clock) ? packet.clock() : clock);
+    player_id_column.push_back(packet.has_property(property_t::player_id) ? packet.player_id() : 0);
+    property_column.push_back(packet.get_property_mask());
+
+    // the offsets column is terminated by the end of the last packet, which is the start of this packet
+    assert(offset_column.empty() || offset == offset_column.back());
+    if (offset_column.empty()) {
+        offset_column.push_back(offset);
+    }
+    offset_column.push_back(offset + static_cast<uint32_t>(data.size()));
+}
+
+void packet_table_t::reserve(size_t size) {
+    type_column.reserve(size);
+    clock_column.reserve(size);
+    player_id_column.reserve(size);
+    offset_column.reserve(size + 1);
+    property_column.reserve(size);
+}
+
+void packet_table_t::shrink_to_fit() {
+    type_column.shrink_to_fit();
+    clock_column.shrink_to_fit();
+    player_id_column.shrink_to_fit();
+    offset_column.shrink_to_fit();
+    property_column.shrink_to_fit();
+}
+
+void packet_table_t::clear() {
+    type_column.clear();
+    clock_column.clear();
+    player_id_column.clear();
+    offset_column.clear();
+    property_column.clear();
+}
+
+const std::vector<uint32_t> &packet_table_t::types() const {
+    return type_column;
+}
+
+const std::vector<float> &packet_table_t::clocks() const {
+    return clock_column;
+}
+
+const std::vector<uint32_t> &packet_table_t::player_ids() const {
+    return player_id_column;
+}
+
+const std::vector<uint32_t> &packet_table_t::offsets() const {
+    return offset_column;
+}
+
+const std::vector<property_mask_t> &packet_table_t::property_masks() const {
+    return property_column;
+}
@@ -0,0 +1,135 @@
+#ifndef wotreplay_packet_table_h
+#define wotreplay_packet_table_h
+
+#include "packet.h"
+#include "types.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/** @file */
+
+namespace wotreplay {
+    /**
+     * wotreplay::packet_table_t stores the packets of a replay as a set of parallel columns. The fields used
+     * to select packets are copied into the table, all other fields are read from the decompressed replay
+     * using the offset of the packet.
+     */
+    class packet_table_t {
+    public:
+        /**
+         * Adds a packet to the table. The packets are stored without a size, the size of a packet is
+         * the distance to the offset of the next packet. The packets are added in the order of the replay
+         * and must be contiguous, each packet starts at the end of the previous packet.
+         * @param packet The packet to add.
+         * @param offset The offset of the packet in the decompressed replay, the end of the previous packet.
+         */
+        void push_back(const packet_t &packet, uint32_t offset);
+        /**
+         * Reserve space for a number of packets.
+         * @param size The number of packets.
+         */
+        void reserve(size_t size);
+        /**
+         * Release the unused capacity of the columns.
+         */
+        void shrink_to_fit();
+        /**
+         * Removes all packets from the table.
+         */
+        void clear();
+        /** @return The number of packets in the table. */
+        size_t size() const;
+        /** @return \c true if the table contains no packets */
+        bool empty() const;
+        /** @return The type of packet ix. */
+        uint32_t type(size_t ix) const;
+        /**
+         * @return The clock of packet ix, for packets without the property clock the clock of the previous
+         * packet. The clocks do not decrease, the column can be searched with a binary search.
+         */
+        float clock(size_t ix) const;
+        /** @return The player id of packet ix, 0 if the packet does not have the property player_id. */
+        uint32_t player_id(size_t ix) const;
+        /** @return The offset of packet ix in the decompressed replay. */
+        uint32_t offset(size_t ix) const;
+        /** @return The size of packet ix in bytes. */
+        uint32_t size(size_t ix) const;
+        /** @return The properties of packet ix. */
+        property_mask_t properties(size_t ix) const;
+        /**
+         * Determines if packet ix has the property specified.
+         * @param ix The index of the packet
+         * @param p The property
+         * @return \c true if the packet contains the property, \c false if not.
+         */
+        bool has_property(size_t ix, property_t p) const;
+        /**
+         * Creates a packet_t referring to packet ix.
+         * @param ix The index of the packet
+         * @param replay The decompressed replay containing the packets of this table.
+         * @return The packet
+         */
+        packet_t packet(size_t ix, const buffer_t &replay) const;
+        /** @return The column with the types of the packets. */
+        const std::vector<uint32_t> &types() const;
+        /** @return The column with the clocks of the packets. */
+        const std::vector<float> &clocks() const;
+        /** @return The column with the player ids of the packets. */
+        const std::vector<uint32_t> &player_ids() const;
+        /** @return The column with the offsets of the packets, it has one extra entry with the end of the last packet. */
+        const std::vector<uint32_t> &offsets() const;
+        /** @return The column with the properties of the packets. */
+        const std::vector<property_mask_t> &property_masks() const;
+    private:
+        std::vector<uint32_t> type_column;
+        std::vector<float> clock_column;
+        std::vector<uint32_t> player_id_column;
+        std::vector<uint32_t> offset_column;
+        std::vector<property_mask_t> property_column;
+    };
+
+    inline size_t packet_table_t::size() const {
+        return type_column.size();
+    }
+
+    inline bool packet_table_t::empty() const {
+        return type_column.empty();
+    }
+
+    inline uint32_t packet_table_t::type(size_t ix) const {
+        return type_column[ix];
+    }
+
+    inline float packet_table_t::clock(size_t ix) const {
+        return clock_column[ix];
+    }
+
+    inline uint32_t packet_table_t::player_id(size_t ix) const {
+        return player_id_column[ix];
+    }
+
+    inline uint32_t packet_table_t::offset(size_t ix) const {
+        return offset_column[ix];
+    }
+
+    inline uint32_t packet_table_t::size(size_t ix) const {
+        return offset_column[ix + 1] - offset_column[ix];
+    }
+
+    inline property_mask_t packet_table_t::properties(size_t ix) const {
+        return property_column[ix];
+    }
+
+    inline bool packet_table_t::has_property(size_t ix, property_t p) const {
+        return (property_column[ix] >> static_cast<size_t>(p)) & 1;
+    }
+
+    inline packet_t packet_table_t::packet(size_t ix, const buffer_t &replay) const {
+        const uint8_t *begin = replay.data() + offset_column[ix];
+        return packet_t(slice_t(begin, begin + size(ix)), property_column[ix]);
+    }
+}
+
+#endif /* defined(wotreplay_packet_table_h) */
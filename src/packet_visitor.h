@@ -0,0 +1,263 @@
+#ifndef wotreplay_packet_visitor_h
+#define wotreplay_packet_visitor_h
+
+#include "game.h"
+#include "packet.h"
+#include "packet_schema.h"
+
+#include <stdint.h>
+#include <string>
+#include <tuple>
+
+/** @file */
+
+namespace wotreplay {
+    /** Decoded fields of a position packet (type 0x0A) */
+    struct position_event_t {
+        float clock;
+        uint32_t player_id;
+        std::tuple<float, float, float> position;
+        std::tuple<float, float, float> hull_orientation;
+    };
+
+    /** Decoded fields of a health update (type 0x07 sub type 0x05, type 0x08 sub type 0x01) */
+    struct health_event_t {
+        float clock;
+        uint32_t player_id;
+        uint16_t health;
+        /** player causing the update, 0 for packets of type 0x07 */
+        uint32_t source;
+    };
+
+    /** Decoded fields of a hit (type 0x08 sub type 0x05) */
+    struct damage_event_t {
+        float clock;
+        uint32_t player_id;
+        uint32_t source;
+    };
+
+    /** Decoded fields of a module damage (type 0x08 sub type 0x0B) */
+    struct module_damage_event_t {
+        float clock;
+        uint32_t player_id;
+        uint32_t source;
+        uint32_t target;
+    };
+
+    /** Decoded fields of a destroyed track (type 0x07 sub type 0x07) */
+    struct track_destroyed_event_t {
+        float clock;
+        uint32_t player_id;
+        /** 0x1D for the left track, 0x1E for the right track, 0 if unknown */
+        uint8_t track_id;
+    };
+
+    /** Decoded fields of a battle log message (type 0x23) */
+    struct message_event_t {
+        float clock;
+        std::string message;
+    };
+
+    /** Decoded fields of a destroyed tank (type 0x08 with the tank destroyed signature) */
+    struct tank_destroyed_event_t {
+        float clock;
+        uint32_t target;
+        uint32_t destroyed_by;
+        /** 0: shell, 1: fire, 2: ram, 3: crash */
+        uint8_t type;
+    };
+
+    /**
+     * wotreplay::packet_visitor_t dispatches a packet to a handler for its type, the fields
+     * of the packet are decoded once and passed to the handler. The visitor is the derived
+     * class (CRTP), its handlers are resolved at compile time and can be inlined. Handlers
+     * which are not defined by the derived class forward to on_packet.
+     *
+     * Example:
+     * \code
+     * struct counter_t : public packet_visitor_t<counter_t> {
+     *     void on_position(const game_t &game, const packet_t &packet, const position_event_t &event) {
+     *         count += 1;
+     *     }
+     *     int count = 0;
+     * };
+     * \endcode
+     */
+    template <typename derived_t>
+    class packet_visitor_t {
+    public:
+        /**
+         * Dispatch a packet to the handler for its type
+         * @param game The game the packet belongs to
+         * @param packet The packet
+         */
+        void visit(const game_t &game, const packet_t &packet);
+        /** Handler for packets without a more specific handler */
+        void on_packet(const game_t &game, const packet_t &packet) {}
+        /** Handler for position packets */
+        void on_position(const game_t &game, const packet_t &packet, const position_event_t &event) {
+            self().on_packet(game, packet);
+        }
+        /** Handler for health updates */
+        void on_health(const game_t &game, const packet_t &packet, const health_event_t &event) {
+            self().on_packet(game, packet);
+        }
+        /** Handler for hits */
+        void on_damage(const game_t &game, const packet_t &packet, const damage_event_t &event) {
+            self().on_packet(game, packet);
+        }
+        /** Handler for module damage */
+        void on_module_damage(const game_t &game, const packet_t &packet, const module_damage_event_t &event) {
+            self().on_packet(game, packet);
+        }
+        /** Handler for destroyed tracks */
+        void on_track_destroyed(const game_t &game, const packet_t &packet, const track_destroyed_event_t &event) {
+            self().on_packet(game, packet);
+        }
+        /** Handler for battle log messages */
+        void on_message(const game_t &game, const packet_t &packet, const message_event_t &event) {
+            self().on_packet(game, packet);
+        }
+        /** Handler for destroyed tanks */
+        void on_tank_destroyed(const game_t &game, const packet_t &packet, const tank_destroyed_event_t &event) {
+            self().on_packet(game, packet);
+        }
+    private:
+        derived_t &self() {
+            return static_cast<derived_t&>(*this);
+        }
+    };
+
+    template <typename derived_t>
+    void packet_visitor_t<derived_t>::visit(const game_t &game, const packet_t &packet) {
+        // the type of the packet guarantees the layout, the offsets of the fields are known at compile time
+        const slice_t &data = packet.get_data();
+        auto begin = data.begin(), end = data.end();
+
+        constexpr size_t type_offset = schema_offset(any_packet_type, any_sub_type, property_t::type);
+
+        switch (get_field<uint32_t>(begin, end, type_offset)) {
+            case 0x0a: {
+                constexpr size_t clock_offset = schema_offset(0x0a, any_sub_type, property_t::clock);
+                constexpr size_t player_id_offset = schema_offset(0x0a, any_sub_type, property_t::player_id);
+                constexpr size_t position_offset = schema_offset(0x0a, any_sub_type, property_t::position);
+                constexpr size_t hull_orientation_offset = schema_offset(0x0a, any_sub_type, property_t::hull_orientation);
+                position_event_t event = {
+                    get_field<float>(begin, end, clock_offset),
+                    get_field<uint32_t>(begin, end, player_id_offset),
+                    std::make_tuple(get_field<float>(begin, end, position_offset),
+                                    get_field<float>(begin, end, position_offset + 4),
+                                    get_field<float>(begin, end, position_offset + 8)),
+                    std::make_tuple(get_field<float>(begin, end, hull_orientation_offset),
+                                    get_field<float>(begin, end, hull_orientation_offset + 4),
+                                    get_field<float>(begin, end, hull_orientation_offset + 8))
+                };
+                self().on_position(game, packet, event);
+                break;
+            }
+            case 0x07: {
+                constexpr size_t clock_offset = schema_offset(0x07, any_sub_type, property_t::clock);
+                constexpr size_t player_id_offset = schema_offset(0x07, any_sub_type, property_t::player_id);
+                constexpr size_t sub_type_offset = schema_offset(0x07, any_sub_type, property_t::sub_type);
+                switch (get_field<uint32_t>(begin, end, sub_type_offset)) {
+                    case 0x05: {
+                        constexpr size_t health_offset = schema_offset(0x07, 0x05, property_t::health);
+                        health_event_t event = {
+                            get_field<float>(begin, end, clock_offset),
+                            get_field<uint32_t>(begin, end, player_id_offset),
+                            get_field<uint16_t>(begin, end, health_offset),
+                            0
+                        };
+                        self().on_health(game, packet, event);
+                        break;
+                    }
+                    case 0x07: {
+                        track_destroyed_event_t event = {
+                            get_field<float>(begin, end, clock_offset),
+                            get_field<uint32_t>(begin, end, player_id_offset),
+                            packet.destroyed_track_id()
+                        };
+                        self().on_track_destroyed(game, packet, event);
+                        break;
+                    }
+                    default:
+                        self().on_packet(game, packet);
+                        break;
+                }
+                break;
+            }
+            case 0x08: {
+                constexpr size_t clock_offset = schema_offset(0x08, any_sub_type, property_t::clock);
+                constexpr size_t player_id_offset = schema_offset(0x08, any_sub_type, property_t::player_id);
+                constexpr size_t sub_type_offset = schema_offset(0x08, any_sub_type, property_t::sub_type);
+                // a destroyed tank takes precedence over the sub type
+                if (packet.has_property(property_t::tank_destroyed)) {
+                    constexpr size_t tank_destroyed_offset = schema_offset(0x08, any_sub_type, property_t::tank_destroyed);
+                    tank_destroyed_event_t event = {
+                        get_field<float>(begin, end, clock_offset),
+                        get_field<uint32_t>(begin, end, tank_destroyed_offset),
+                        get_field<uint32_t>(begin, end, tank_destroyed_offset + 5),
+                        get_field<uint8_t>(begin, end, tank_destroyed_offset + 12)
+                    };
+                    self().on_tank_destroyed(game, packet, event);
+                    break;
+                }
+
+                switch (get_field<uint32_t>(begin, end, sub_type_offset)) {
+                    case 0x01: {
+                        constexpr size_t health_offset = schema_offset(0x08, 0x01, property_t::health);
+                        constexpr size_t source_offset = schema_offset(0x08, 0x01, property_t::source);
+                        health_event_t event = {
+                            get_field<float>(begin, end, clock_offset),
+                            get_field<uint32_t>(begin, end, player_id_offset),
+                            get_field<uint16_t>(begin, end, health_offset),
+                            get_field<uint32_t>(begin, end, source_offset)
+                        };
+                        self().on_health(game, packet, event);
+                        break;
+                    }
+                    case 0x05: {
+                        constexpr size_t source_offset = schema_offset(0x08, 0x05, property_t::source);
+                        damage_event_t event = {
+                            get_field<float>(begin, end, clock_offset),
+                            get_field<uint32_t>(begin, end, player_id_offset),
+                            get_field<uint32_t>(begin, end, source_offset)
+                        };
+                        self().on_damage(game, packet, event);
+                        break;
+                    }
+                    case 0x0B: {
+                        constexpr size_t source_offset = schema_offset(0x08, 0x0B, property_t::source);
+                        constexpr size_t target_offset = schema_offset(0x08, 0x0B, property_t::target);
+                        module_damage_event_t event = {
+                            get_field<float>(begin, end, clock_offset),
+                            get_field<uint32_t>(begin, end, player_id_offset),
+                            get_field<uint32_t>(begin, end, source_offset),
+                            get_field<uint32_t>(begin, end, target_offset)
+                        };
+                        self().on_module_damage(game, packet, event);
+                        break;
+                    }
+                    default:
+                        self().on_packet(game, packet);
+                        break;
+                }
+                break;
+            }
+            case 0x23: {
+                constexpr size_t clock_offset = schema_offset(0x23, any_sub_type, property_t::clock);
+                message_event_t event = {
+                    get_field<float>(begin, end, clock_offset),
+                    packet.message()
+                };
+                self().on_message(game, packet, event);
+                break;
+            }
+            default:
+                self().on_packet(game, packet);
+                break;
+        }
+    }
+}
+
+#endif /* defined(wotreplay_packet_visitor_h) */
@@ -1,27 +1,37 @@
-#include "json/json.h"
-
 #include "arena.h"
 #include "cipher_context.h"
+#include "json_scanner.h"
 #include "logger.h"
 #include "packet_reader.h"
-#include "packet_reader_80.h"
 #include "parser.h"
 #include "regex.h"
+#include "replay_cache.h"
+#include "replay_stream.h"
 #include "tank.h"
 
 #include <boost/format.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 #include <boost/lexical_cast.hpp>
+#include <algorithm>
+#include <cstring>
 #include <fstream>
+#include <limits>
 #include <map>
 #include <memory>
 #include <ostream>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <type_traits>
 
 #include <zlib.h>
 
+#ifdef ENABLE_LIBDEFLATE
+#include <libdeflate.h>
+#endif
+
 using namespace wotreplay;
 using namespace boost::filesystem;
 
@@ -52,7 +62,14 @@ static std::map<game_title_t, std::array<unsigned char, 16>> encryption_keys =
 };
 
 parser_t::parser_t(load_data_mode_t load_data_mode, bool debug)
-    : debug(debug), load_data_mode(load_data_mode)
+    : debug(debug), load_data_mode(load_data_mode), decryption_mode(decryption_mode_t::prefix_xor), thread_count(0),
+      cipher_backend(cipher_backend_t::builtin),
+#ifdef ENABLE_LIBDEFLATE
+      inflate_backend(inflate_backend_t::libdeflate),
+#else
+      inflate_backend(inflate_backend_t::zlib),
+#endif
+      compact(false), max_clock(std::numeric_limits<float>::infinity())
 {
     // empty
     if (load_data_mode == load_data_mode_t::bulk) {
@@ -61,16 +78,212 @@ parser_t::parser_t(load_data_mode_t load_data_mode, bool debug)
 }
 
 void parser_t::parse(std::istream &is, wotreplay::game_t &game) {
-    buffer_t buffer((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
-    parse(buffer, game);
+    auto buffer = std::make_shared<buffer_t>((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+    parse(buffer->data(), buffer->data() + buffer->size(), buffer, true, game);
 }
 
 void parser_t::parse(buffer_t &buffer, wotreplay::game_t &game) {
+    // the game outlives the buffer of the caller, keep a copy of the contents
+    auto copy = std::make_shared<buffer_t>(buffer);
+    parse(copy->data(), copy->data() + copy->size(), copy, true, game);
+}
+
+void parser_t::parse(const boost::filesystem::path &path, wotreplay::game_t &game) {
+    if (file_size(path) == 0) {
+        throw std::runtime_error("No data");
+    }
+
+    boost::interprocess::file_mapping mapping(path.string().c_str(), boost::interprocess::read_only);
+    auto region = std::make_shared<boost::interprocess::mapped_region>(mapping, boost::interprocess::read_only);
+    const uint8_t *begin = static_cast<const uint8_t*>(region->get_address());
+    parse(begin, begin + region->get_size(), region, false, game);
+}
+
+void parser_t::parse(std::istream &is, wotreplay::game_t &game, const packet_callback_t &callback) {
+    auto buffer = std::make_shared<buffer_t>((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+    parse(buffer->data(), buffer->data() + buffer->size(), buffer, game, callback);
+}
+
+void parser_t::parse(const boost::filesystem::path &path, wotreplay::game_t &game, const packet_callback_t &callback) {
+    if (file_size(path) == 0) {
+        throw std::runtime_error("No data");
+    }
+
+    boost::interprocess::file_mapping mapping(path.string().c_str(), boost::interprocess::read_only);
+    auto region = std::make_shared<boost::interprocess::mapped_region>(mapping, boost::interprocess::read_only);
+    const uint8_t *begin = static_cast<const uint8_t*>(region->get_address());
+    parse(begin, begin + region->get_size(), region, game, callback);
+}
+
+void parser_t::peek(std::istream &is, wotreplay::game_t &game) {
+    // only read the header and the data blocks preceding the replay data block
+    auto buffer = std::make_shared<buffer_t>(8);
+    if (!is.read(reinterpret_cast<char*>(buffer->data()), buffer->size())) {
+        throw std::runtime_error("No data");
+    }
+
+    uint32_t nr_data_blocks = get_data_block_count(buffer->data(), buffer->data() + buffer->size());
+    for (uint32_t ix = 0; ix < nr_data_blocks; ++ix) {
+        size_t offset = buffer->size();
+        buffer->resize(offset + sizeof(uint32_t));
+        if (!is.read(reinterpret_cast<char*>(buffer->data() + offset), sizeof(uint32_t))) {
+            throw std::runtime_error("Invalid block size.");
+        }
+
+        // the block size is not validated, the block is read in chunks so an invalid size fails at the
+        // end of the stream instead of allocating the size up front
+        const size_t chunk_size = 64 * 1024;
+        size_t remaining = get_field<uint32_t>(buffer->begin(), buffer->end(), offset);
+        while (remaining > 0) {
+            size_t size = std::min(remaining, chunk_size);
+            offset = buffer->size();
+            buffer->resize(offset + size);
+            if (!is.read(reinterpret_cast<char*>(buffer->data() + offset), size)) {
+                throw std::runtime_error("Invalid block size.");
+            }
+            remaining -= size;
+        }
+    }
+
+    peek(buffer->data(), buffer->data() + buffer->size(), buffer, game);
+}
+
+void parser_t::peek(const boost::filesystem::path &path, wotreplay::game_t &game) {
+    if (file_size(path) == 0) {
+        throw std::runtime_error("No data");
+    }
+
+    // only the pages containing the data blocks preceding the replay data block are read
+    boost::interprocess::file_mapping mapping(path.string().c_str(), boost::interprocess::read_only);
+    auto region = std::make_shared<boost::interprocess::mapped_region>(mapping, boost::interprocess::read_only);
+    const uint8_t *begin = static_cast<const uint8_t*>(region->get_address());
+    peek(begin, begin + region->get_size(), region, game);
+}
+
+void parser_t::peek(const uint8_t *begin, const uint8_t *end, std::shared_ptr<const void> storage,
+                    wotreplay::game_t &game) {
+    std::vector<slice_t> data_blocks;
+    get_json_blocks(begin, end, data_blocks);
+
+    if (data_blocks.empty()) {
+        throw std::runtime_error("Unexpected number of data blocks (0).");
+    }
+
+    read_metadata(data_blocks, storage, game);
+}
+
+void parser_t::build_index(const boost::filesystem::path &path, replay_index_t &index, size_t span) {
+    if (file_size(path) == 0) {
+        throw std::runtime_error("No data");
+    }
+
+    boost::interprocess::file_mapping mapping(path.string().c_str(), boost::interprocess::read_only);
+    auto region = std::make_shared<boost::interprocess::mapped_region>(mapping, boost::interprocess::read_only);
+    const uint8_t *begin = static_cast<const uint8_t*>(region->get_address());
+
+    game_t game;
+    const slice_t replay_block = read_data_blocks(begin, begin + region->get_size(), region, game);
+    buffer_t replay_data(replay_block.begin(), replay_block.end());
+
+    auto key = encryption_keys[game.get_game_title()].data();
+
+    uint32_t decompressed_size = get_field<uint32_t>(replay_block.begin(), replay_block.end(), 0);
+    uint32_t compressed_size = get_field<uint32_t>(replay_block.begin(), replay_block.end(), 4);
+    decrypt_replay(replay_data.data() + 8, replay_data.data() + replay_data.size(), key);
+
+    index.build(replay_data.data() + 8, compressed_size, decompressed_size, span);
+}
+
+void parser_t::load_index(const boost::filesystem::path &path, replay_index_t &index) {
+    if (file_size(path) == 0) {
+        throw std::runtime_error("No data");
+    }
+
+    // validate the index with the sizes of the replay data block
+    boost::interprocess::file_mapping mapping(path.string().c_str(), boost::interprocess::read_only);
+    boost::interprocess::mapped_region region(mapping, boost::interprocess::read_only);
+    const uint8_t *begin = static_cast<const uint8_t*>(region.get_address());
+    std::vector<slice_t> data_blocks;
+    get_data_blocks(begin, begin + region.get_size(), data_blocks);
+    if (data_blocks.size() < 2) {
+        throw std::runtime_error((boost::format("Unexpected number of data blocks (%1%).") % data_blocks.size()).str());
+    }
+
+    const slice_t &replay_block = data_blocks.back();
+    uint32_t decompressed_size = get_field<uint32_t>(replay_block.begin(), replay_block.end(), 0);
+    uint32_t compressed_size = get_field<uint32_t>(replay_block.begin(), replay_block.end(), 4);
+
+    boost::filesystem::path index_path = path.string() + ".idx";
+    std::ifstream is(index_path.string(), std::ios::binary);
+    if (is && index.read(is) && index.matches(compressed_size, decompressed_size)) {
+        return;
+    }
+
+    build_index(path, index);
+
+    std::ofstream os(index_path.string(), std::ios::binary);
+    index.write(os);
+    if (!os) {
+        logger.writef(log_level_t::warning, "Failed to write index: %1%\n", index_path.string());
+    }
+}
+
+void parser_t::parse_range(const boost::filesystem::path &path, wotreplay::game_t &game, const replay_index_t &index,
+                           float begin_clock, float end_clock, const packet_callback_t &callback) {
+    if (file_size(path) == 0) {
+        throw std::runtime_error("No data");
+    }
+
+    boost::interprocess::file_mapping mapping(path.string().c_str(), boost::interprocess::read_only);
+    auto region = std::make_shared<boost::interprocess::mapped_region>(mapping, boost::interprocess::read_only);
+    const uint8_t *begin = static_cast<const uint8_t*>(region->get_address());
+    const slice_t replay_block = read_data_blocks(begin, begin + region->get_size(), region, game);
+
+    uint32_t decompressed_size = get_field<uint32_t>(replay_block.begin(), replay_block.end(), 0);
+    uint32_t compressed_size = get_field<uint32_t>(replay_block.begin(), replay_block.end(), 4);
+    if (!index.matches(compressed_size, decompressed_size)) {
+        throw std::runtime_error("The index does not match the replay file.");
+    }
+
+    const buffer_t &header = index.get_header();
+    read_version(header.data(), header.data() + header.size(), game);
+    packet_reader->init(game.version, nullptr, game.title);
+
+    auto key = encryption_keys[game.get_game_title()].data();
+    const inflate_checkpoint_t &checkpoint = index.find(begin_clock);
+    replay_stream_t stream(replay_block.begin() + 8, replay_block.end(), compressed_size, key, cipher_backend, checkpoint);
+
+    // skip the end of the packet preceding the checkpoint
+    buffer_t skipped(64 * 1024);
+    size_t skip = checkpoint.packet_offset - checkpoint.output_offset;
+    while (skip > 0 && !stream.eof()) {
+        skip -= stream.read(skipped.data(), std::min(skip, skipped.size()));
+    }
+
+    float clock = checkpoint.clock;
+    frame_stream(stream, game, false, [&](const packet_t &packet) {
+        if (packet.has_property(property_t::clock)) {
+            clock = packet.clock();
+        }
+
+        // the packets are ordered by clock, the remainder of the replay is not decoded
+        if (clock > end_clock) {
+            return false;
+        }
+
+        if (clock >= begin_clock) {
+            callback(game, packet);
+        }
+        return true;
+    });
+}
+
+slice_t parser_t::read_data_blocks(const uint8_t *begin, const uint8_t *end, std::shared_ptr<const void> storage,
+                                   wotreplay::game_t &game) {
     // determine number of data blocks
     std::vector<slice_t> data_blocks;
-    buffer_t raw_replay;
     
-    get_data_blocks(buffer, data_blocks);
+    get_data_blocks(begin, end, data_blocks);
 
     if (debug) {
         for (int i = 0; i < data_blocks.size(); ++i) {
@@ -84,56 +297,291 @@ void parser_t::parse(buffer_t &buffer, wotreplay::game_t &game) {
         throw std::runtime_error(message);
     }
 
-    buffer_t &game_begin = game.game_begin;    
-    game_begin.resize(data_blocks[0].size());
-    std::copy(data_blocks[0].begin(), data_blocks[0].end(), game_begin.begin());
+    slice_t replay_block = data_blocks.back();
+    data_blocks.pop_back();
+    read_metadata(data_blocks, storage, game);
+
+    return replay_block;
+}
 
-    buffer_t &player_info = game.player_info;    
-    player_info.resize(data_blocks[1].size());
-    std::copy(data_blocks[1].begin(), data_blocks[1].end(), player_info.begin());
+void parser_t::read_metadata(const std::vector<slice_t> &data_blocks, std::shared_ptr<const void> storage,
+                             wotreplay::game_t &game) {
+    game.storage = storage;
+    game.game_begin = data_blocks[0];
+    game.reset_caches();
 
-    if (data_blocks.size() == 3) {
-        // third block contains game summary
-        buffer_t &game_end = game.game_end;
-        game_end.resize(data_blocks[1].size());
-        std::copy(data_blocks[1].begin(), data_blocks[1].end(), game_end.begin());
+    if (data_blocks.size() > 1) {
+        game.player_info = data_blocks[1];
+    }
+
+    if (data_blocks.size() == 2) {
+        // second block contains game summary
+        game.game_end = data_blocks[1];
     }
 
-    raw_replay.resize(data_blocks.back().size());
-    std::copy(data_blocks.back().begin(), data_blocks.back().end(), raw_replay.begin());
-        
 	read_player_info(game);
     read_arena_info(game);
+}
 
-	auto key = encryption_keys[game.get_game_title()].data();
+void parser_t::parse(const uint8_t *begin, const uint8_t *end, std::shared_ptr<const void> storage,
+                     bool writable, wotreplay::game_t &game) {
+    std::string cache_key;
+    slice_t cached_replay;
+    if (!cache_directory.empty()) {
+        cache_key = replay_cache_t::get_key(begin, end);
+    }
 
-    uint32_t decompressed_size = *reinterpret_cast<const uint32_t *>(&raw_replay[0]);
-    uint32_t compressed_size = *reinterpret_cast<const uint32_t *>(&raw_replay[4]);
-    decrypt_replay(raw_replay.data() + 8, raw_replay.data() + raw_replay.size(), key);
+    bool cached = !cache_key.empty() && read_cache(cache_key, game, cached_replay);
+    bool limited = max_clock != std::numeric_limits<float>::infinity();
+    bool pipelined = decryption_mode == decryption_mode_t::pipelined;
+    bool framed = limited || (pipelined && !cached);
+    bool complete = true;
+
+    // with a clock limit, the packets are framed while the replay is decoded so decoding stops at the limit,
+    // in pipelined mode the packets are framed while the next chunks are decrypted
+    buffer_t replay;
+    auto append = [&replay](const game_t &game, const packet_t &packet) {
+        replay.insert(replay.end(), packet.get_data().begin(), packet.get_data().end());
+    };
+
+    if (cached && !limited) {
+        game.replay.assign(cached_replay.begin(), cached_replay.end());
+    } else if (cached) {
+        complete = frame_packets(cached_replay, game, append);
+        game.replay.swap(replay);
+    } else if (limited || pipelined) {
+        const slice_t replay_block = read_data_blocks(begin, end, storage, game);
+        if (!limited) {
+            replay.reserve(get_field<uint32_t>(replay_block.begin(), replay_block.end(), 0));
+        }
+
+        complete = stream_packets(replay_block, game, append);
+        game.replay.swap(replay);
+    } else {
+        buffer_t raw_replay;
+        const slice_t replay_block = read_data_blocks(begin, end, storage, game);
+
+        // decrypt the replay data block in place when possible, otherwise work on a copy
+        unsigned char *replay_data;
+        if (writable) {
+            replay_data = const_cast<unsigned char*>(replay_block.begin());
+        } else {
+            raw_replay.assign(replay_block.begin(), replay_block.end());
+            replay_data = raw_replay.data();
+        }
 
-    game.replay.resize(decompressed_size, 0);
-    extract_replay(raw_replay.data() + 8, raw_replay.data() + 8 + compressed_size, game.replay);
+        auto key = encryption_keys[game.get_game_title()].data();
+
+        uint32_t decompressed_size = get_field<uint32_t>(replay_block.begin(), replay_block.end(), 0);
+        uint32_t compressed_size = get_field<uint32_t>(replay_block.begin(), replay_block.end(), 4);
+        decrypt_replay(replay_data + 8, replay_data + replay_block.size(), key);
+
+        game.replay.resize(decompressed_size);
+        extract_replay(replay_data + 8, replay_data + 8 + compressed_size, game.replay);
+    }
 
 	debug_stream_content("replay.dat", game.replay.begin(), game.replay.end());
-    
-    // read version string
-    uint32_t version_string_sz = get_field<uint32_t>(game.replay.begin(), game.replay.end(), 12);
-    std::string version(game.replay.begin() + 16, game.replay.begin() + 16 + version_string_sz);
-    game.version = version_t(version);
-    
-    if (!this->setup(game.version)) {
-        logger.writef(log_level_t::warning, "Warning: Replay version (%1%) not marked as compatible.\n", game.version.text);
+
+    if (!framed) {
+        read_version(game.replay.data(), game.replay.data() + game.replay.size(), game);
+
+        // validate the framing of the packets, the packets are read on demand
+        packet_reader->init(game.version, &game.replay, game.title);
+        while (packet_reader->has_next()) {
+            packet_reader->skip();
+        }
+        packet_reader->end();
+    }
+
+    if (!cache_key.empty() && !cached && complete) {
+        write_cache(cache_key, begin, end, slice_t(game.replay.data(), game.replay.data() + game.replay.size()));
     }
 
-    read_packets(game);
+    game.reset_caches();
 
     if (debug) {
         show_packet_summary(game.get_packets());
     }
+
+    if (compact) {
+        game.compact(compact_types);
+    }
+}
+
+void parser_t::parse(const uint8_t *begin, const uint8_t *end, std::shared_ptr<const void> storage,
+                     wotreplay::game_t &game, const packet_callback_t &callback) {
+    // the replay is not stored in the game, the packets of a game parsed before are released
+    buffer_t().swap(game.replay);
+
+    std::string cache_key;
+    slice_t cached_replay;
+    if (!cache_directory.empty()) {
+        cache_key = replay_cache_t::get_key(begin, end);
+    }
+
+    if (!cache_key.empty() && read_cache(cache_key, game, cached_replay)) {
+        // the packets are framed directly from the mapped cache entry
+        frame_packets(cached_replay, game, callback);
+        return;
+    }
+
+    const slice_t replay_block = read_data_blocks(begin, end, storage, game);
+
+    if (cache_key.empty()) {
+        stream_packets(replay_block, game, callback);
+        return;
+    }
+
+    // the decompressed replay is only kept when it is written to the cache
+    buffer_t replay;
+    bool complete = stream_packets(replay_block, game, [&](const game_t &game, const packet_t &packet) {
+        replay.insert(replay.end(), packet.get_data().begin(), packet.get_data().end());
+        callback(game, packet);
+    });
+
+    if (complete) {
+        write_cache(cache_key, begin, end, slice_t(replay.data(), replay.data() + replay.size()));
+    }
+}
+
+bool parser_t::is_past_limit(const packet_t &packet) const {
+    return packet.has_property(property_t::clock) && packet.clock() > max_clock;
+}
+
+bool parser_t::frame_packets(const slice_t &replay, wotreplay::game_t &game, const packet_callback_t &callback) {
+    read_version(replay.begin(), replay.end(), game);
+    packet_reader->init(game.version, nullptr, game.title);
+
+    size_t head = 0;
+    bool complete = frame_window(replay.begin(), replay.end(), head, [&](const packet_t &packet) {
+        return limit_packet(game, packet, callback);
+    });
+
+    if (!complete) {
+        return false;
+    }
+
+    if (head != replay.size()) {
+        throw std::runtime_error("packet outside of bounds");
+    }
+
+    packet_reader->end();
+    return true;
+}
+
+bool parser_t::frame_window(const uint8_t *begin, const uint8_t *end, size_t &head, const packet_handler_t &handler) {
+    packet_t packet;
+    while (packet_reader->next(begin + head, end, packet)) {
+        if (!handler(packet)) {
+            return false;
+        }
+        head += packet.get_data().size();
+    }
+    return true;
+}
+
+bool parser_t::limit_packet(const wotreplay::game_t &game, const packet_t &packet, const packet_callback_t &callback) const {
+    // the remainder of the replay is not framed
+    if (is_past_limit(packet)) {
+        return false;
+    }
+
+    callback(game, packet);
+    return true;
+}
+
+bool parser_t::stream_packets(const slice_t &replay_block, wotreplay::game_t &game, const packet_callback_t &callback) {
+	auto key = encryption_keys[game.get_game_title()].data();
+
+    uint32_t compressed_size = get_field<uint32_t>(replay_block.begin(), replay_block.end(), 4);
+    replay_stream_t stream(replay_block.begin() + 8, replay_block.end(), compressed_size, key, cipher_backend,
+                           decryption_mode == decryption_mode_t::pipelined);
+
+    return frame_stream(stream, game, true, [&](const packet_t &packet) {
+        return limit_packet(game, packet, callback);
+    });
+}
+
+bool parser_t::frame_stream(replay_stream_t &stream, wotreplay::game_t &game, bool read_header,
+                            const packet_handler_t &handler) {
+    const size_t window_size = 64 * 1024;
+    buffer_t window(window_size);
+    size_t head = 0;
+    size_t tail = stream.read(window.data(), window.size());
+
+    if (read_header) {
+        read_version(window.data(), window.data() + tail, game);
+        packet_reader->init(game.version, nullptr, game.title);
+    }
+
+    while (true) {
+        if (!frame_window(window.data(), window.data() + tail, head, handler)) {
+            return false;
+        }
+
+        if (stream.eof()) {
+            break;
+        }
+
+        // move the incomplete packet to the start of the window
+        std::copy(window.begin() + head, window.begin() + tail, window.begin());
+        tail -= head;
+        head = 0;
+
+        if (tail == window.size()) {
+            window.resize(window.size() * 2);
+        }
+
+        tail += stream.read(window.data() + tail, window.size() - tail);
+    }
+
+    if (head != tail) {
+        throw std::runtime_error("packet outside of bounds");
+    }
+
+    packet_reader->end();
+    return true;
+}
+
+bool parser_t::read_cache(const std::string &key, wotreplay::game_t &game, slice_t &replay) {
+    std::shared_ptr<const void> storage;
+    std::vector<slice_t> data_blocks;
+    if (!replay_cache_t(cache_directory).read(key, storage, data_blocks, replay)) {
+        return false;
+    }
+
+    read_metadata(data_blocks, storage, game);
+    return true;
+}
+
+void parser_t::write_cache(const std::string &key, const uint8_t *begin, const uint8_t *end, const slice_t &replay) {
+    std::vector<slice_t> data_blocks;
+    get_data_blocks(begin, end, data_blocks);
+    data_blocks.pop_back();
+    replay_cache_t(cache_directory).write(key, data_blocks, replay);
+}
+
+void parser_t::read_version(const uint8_t *begin, const uint8_t *end, wotreplay::game_t &game) {
+    const size_t version_string_offset = 16;
+    if (end - begin < version_string_offset) {
+        throw std::runtime_error("Invalid replay data block.");
+    }
+
+    uint32_t version_string_sz = get_field<uint32_t>(begin, end, version_string_offset - sizeof(uint32_t));
+    if (end - begin < version_string_offset + version_string_sz) {
+        throw std::runtime_error("Invalid replay data block.");
+    }
+
+    std::string version(begin + version_string_offset, begin + version_string_offset + version_string_sz);
+    game.version = version_t(version);
+    
+    if (!this->setup(game.version)) {
+        logger.writef(log_level_t::warning, "Warning: Replay version (%1%) not marked as compatible.\n", game.version.text);
+    }
 }
 
 bool parser_t::setup(const version_t &version) {
-    this->packet_reader = std::unique_ptr<packet_reader_t>(new packet_reader_80_t());
+    this->packet_reader = create_packet_reader(version);
     return packet_reader->is_compatible(version);
 }
 
@@ -145,6 +593,63 @@ bool parser_t::get_debug() const {
     return debug;
 }
 
+void parser_t::set_decryption_mode(decryption_mode_t decryption_mode) {
+    this->decryption_mode = decryption_mode;
+}
+
+decryption_mode_t parser_t::get_decryption_mode() const {
+    return decryption_mode;
+}
+
+void parser_t::set_thread_count(unsigned thread_count) {
+    this->thread_count = thread_count;
+}
+
+unsigned parser_t::get_thread_count() const {
+    return thread_count;
+}
+
+void parser_t::set_cipher_backend(cipher_backend_t cipher_backend) {
+    this->cipher_backend = cipher_backend;
+}
+
+cipher_backend_t parser_t::get_cipher_backend() const {
+    return cipher_backend;
+}
+
+void parser_t::set_inflate_backend(inflate_backend_t inflate_backend) {
+    this->inflate_backend = inflate_backend;
+}
+
+inflate_backend_t parser_t::get_inflate_backend() const {
+    return inflate_backend;
+}
+
+void parser_t::set_compact(bool compact, std::vector<uint32_t> types) {
+    this->compact = compact;
+    this->compact_types = std::move(types);
+}
+
+bool parser_t::get_compact() const {
+    return compact;
+}
+
+void parser_t::set_cache_directory(const boost::filesystem::path &cache_directory) {
+    this->cache_directory = cache_directory;
+}
+
+const boost::filesystem::path &parser_t::get_cache_directory() const {
+    return cache_directory;
+}
+
+void parser_t::set_max_clock(float max_clock) {
+    this->max_clock = max_clock;
+}
+
+float parser_t::get_max_clock() const {
+    return max_clock;
+}
+
 bool parser_t::is_legacy_replay(const buffer_t &buffer) const {
     return buffer.size() >= 10 && buffer[8] == 0x78 && buffer[9] == 0xDA;
 }
@@ -155,7 +660,16 @@ bool parser_t::is_legacy() const {
 
 void parser_t::decrypt_replay(unsigned char *begin, unsigned char *end, const unsigned char *key_data) {
     debug_stream_content("replay-ec.dat", begin, end);
-    
+
+    if (decryption_mode == decryption_mode_t::reference) {
+        decrypt_replay_reference(begin, end, key_data);
+        return;
+    }
+
+    decrypt_replay_prefix_xor(begin, end, key_data);
+}
+
+void parser_t::decrypt_replay_reference(unsigned char *begin, unsigned char *end, const unsigned char *key_data) {
     const int block_size = 8;
     const int key_size = 16;
     const unsigned char iv[key_size] = {0};
@@ -163,12 +677,12 @@ void parser_t::decrypt_replay(unsigned char *begin, unsigned char *end, const un
     unsigned char previous[block_size] = {0};
     unsigned char decrypted[block_size] = {0};
 
-    CipherContext cipherContext("BF-ECB", key_data, key_size, iv);
+    CipherContext cipherContext("BF-ECB", key_data, key_size, iv, cipher_backend);
 
     uint32_t pin = 0;
     uint32_t pout = 0;
     int decrypted_len;
-    while (pin < (end - begin)) {
+    while (pin + block_size <= (end - begin)) {
         cipherContext.update(decrypted, &decrypted_len, begin + pin, block_size);
 
         std::transform(previous, previous + decrypted_len, decrypted, decrypted, std::bit_xor<unsigned char>());
@@ -181,20 +695,106 @@ void parser_t::decrypt_replay(unsigned char *begin, unsigned char *end, const un
 
     cipherContext.finalize(decrypted, &decrypted_len);
     std::transform(previous, previous + decrypted_len, decrypted, decrypted, std::bit_xor<unsigned char>());
-    std::copy_n(decrypted, block_size, begin + pout);
+    std::copy_n(decrypted, decrypted_len, begin + pout);
 }
 
-uint32_t parser_t::get_data_block_count(const buffer_t &buffer) const {
+/**
+ * Apply a constant xor to all the 8 byte blocks in [begin, end).
+ * @param begin start of the blocks
+ * @param end end of the blocks
+ * @param value value to xor each block with
+ */
+static void xor_blocks(unsigned char *begin, unsigned char *end, uint64_t value) {
+    for (unsigned char *p = begin; p < end; p += sizeof(value)) {
+        uint64_t block;
+        std::memcpy(&block, p, sizeof(block));
+        block ^= value;
+        std::memcpy(p, &block, sizeof(block));
+    }
+}
+
+/**
+ * Run task(i) for i in [0, count), using a thread for each task except the first one.
+ */
+template <typename task_t>
+static void run_parallel(size_t count, task_t task) {
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < count; ++i) {
+        threads.emplace_back(task, i);
+    }
+    task(0);
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+void parser_t::decrypt_replay_prefix_xor(unsigned char *begin, unsigned char *end, const unsigned char *key_data) {
+    const int block_size = 8;
+    const int key_size = 16;
+    const unsigned char iv[key_size] = {0};
+    // minimum amount of data to justify an additional thread
+    const size_t min_chunk_size = 1024 * 1024;
+    // maximum amount of data passed in a single call to the cipher
+    const size_t max_update_size = 16 * 1024 * 1024;
+
+    size_t block_count = (end - begin) / block_size;
+    size_t max_thread_count = this->thread_count != 0 ? this->thread_count : std::thread::hardware_concurrency();
+    size_t thread_count = std::max<size_t>(1, std::min<size_t>(max_thread_count,
+                                                               block_count * block_size / min_chunk_size));
+    size_t chunk_block_count = (block_count + thread_count - 1) / thread_count;
+
+    auto chunk_begin = [&](size_t i) {
+        return begin + std::min(block_count, i * chunk_block_count) * block_size;
+    };
+
+    // decrypt each chunk and chain the blocks within the chunk
+    std::vector<uint64_t> carries(thread_count, 0);
+    run_parallel(thread_count, [&](size_t i) {
+        unsigned char *first = chunk_begin(i), *last = chunk_begin(i + 1);
+        CipherContext cipherContext("BF-ECB", key_data, key_size, iv, cipher_backend);
+        for (unsigned char *p = first; p < last; p += max_update_size) {
+            int decrypted_len;
+            int len = static_cast<int>(std::min<size_t>(max_update_size, last - p));
+            cipherContext.update(p, &decrypted_len, p, len);
+        }
+        carries[i] = prefix_xor(first, last, 0);
+    });
+
+    // each chunk is chained with the xor of all preceding chunks
+    uint64_t carry = 0;
+    for (auto &chunk_carry : carries) {
+        uint64_t total = chunk_carry;
+        chunk_carry = carry;
+        carry ^= total;
+    }
+
+    run_parallel(thread_count, [&](size_t i) {
+        if (carries[i] != 0) {
+            xor_blocks(chunk_begin(i), chunk_begin(i + 1), carries[i]);
+        }
+    });
+}
+
+uint32_t parser_t::get_data_block_count(const uint8_t *begin, const uint8_t *end) const {
     // number of data blocks is contained in an 'unsigned long' (4 bytes) 
     // with an offset of 4 bytes from the beginning of te file
     const size_t db_cnt_offset = 4;
-    const uint32_t *db_cnt = reinterpret_cast<const uint32_t*>(&buffer[db_cnt_offset]);
-    return *db_cnt;
+    return get_field<uint32_t>(begin, end, db_cnt_offset);
 } 
 
 void parser_t::extract_replay(const unsigned char* begin, const unsigned char* end, buffer_t &replay) {
     debug_stream_content("replay-c.dat", begin, end);
 
+#ifdef ENABLE_LIBDEFLATE
+    if (inflate_backend == inflate_backend_t::libdeflate && extract_replay_libdeflate(begin, end, replay)) {
+        return;
+    }
+#endif
+
+    extract_replay_zlib(begin, end, replay);
+}
+
+void parser_t::extract_replay_zlib(const unsigned char* begin, const unsigned char* end, buffer_t &replay) {
     z_stream strm = { 
         const_cast<unsigned char*>(begin),
         static_cast<uInt>(end - begin)
@@ -208,29 +808,23 @@ void parser_t::extract_replay(const unsigned char* begin, const unsigned char* e
             << ": inflateInit() failed!";
         throw std::runtime_error(msg.str());
     }
-    
-    const int chunk = 1024 * 1024;
-    int p = 0;
-    std::unique_ptr<unsigned char[]> out(new unsigned char[chunk]);
-    
+
+    // inflate in one go, the output buffer only grows when the expected size was too small
+    const size_t chunk = 1024 * 1024;
+    strm.next_out = replay.data();
+    strm.avail_out = static_cast<uInt>(replay.size());
+
     do {
-        strm.avail_out = chunk;
-        strm.next_out = out.get();
-        ret = inflate(&strm, Z_NO_FLUSH);
-        
-        assert(ret != Z_STREAM_ERROR); 
-        switch (ret) {
-            case Z_NEED_DICT:
-                ret = Z_DATA_ERROR;    
-            case Z_DATA_ERROR:
-            case Z_MEM_ERROR:
-                (void)inflateEnd(&strm);
+        if (strm.avail_out == 0) {
+            size_t have = replay.size();
+            replay.resize(have + chunk);
+            strm.next_out = replay.data() + have;
+            strm.avail_out = static_cast<uInt>(chunk);
         }
-        
-        int have = chunk - strm.avail_out;
-        std::copy_n(out.get(), have, &replay[p]);
-        p += have;
-    } while (strm.avail_out == 0);
+
+        ret = inflate(&strm, Z_FINISH);
+        assert(ret != Z_STREAM_ERROR);
+    } while ((ret == Z_OK || ret == Z_BUF_ERROR) && strm.avail_out == 0);
 
     (void)inflateEnd(&strm);
     
@@ -240,91 +834,213 @@ void parser_t::extract_replay(const unsigned char* begin, const unsigned char* e
             << ": infate() failed!\n";
         throw std::runtime_error(msg.str());
     }
+
+    replay.resize(strm.total_out);
 }
 
+#ifdef ENABLE_LIBDEFLATE
+bool parser_t::extract_replay_libdeflate(const unsigned char* begin, const unsigned char* end, buffer_t &replay) {
+    std::unique_ptr<libdeflate_decompressor, void(*)(libdeflate_decompressor*)> decompressor(
+        libdeflate_alloc_decompressor(), &libdeflate_free_decompressor);
 
-void parser_t::get_data_blocks(buffer_t &buffer, std::vector<slice_t> &data_blocks) const {
-    if (buffer.size() == 0) {
+    if (!decompressor) {
+        throw std::bad_alloc();
+    }
+
+    size_t actual_size;
+    libdeflate_result result = libdeflate_zlib_decompress(decompressor.get(), begin, end - begin,
+                                                          replay.data(), replay.size(), &actual_size);
+
+    switch (result) {
+        case LIBDEFLATE_SUCCESS:
+            replay.resize(actual_size);
+            return true;
+        case LIBDEFLATE_INSUFFICIENT_SPACE:
+            // expected size was too small, let zlib handle the growing output
+            return false;
+        default: {
+            std::stringstream msg;
+            msg << __func__
+                << ": libdeflate_zlib_decompress() failed!\n";
+            throw std::runtime_error(msg.str());
+        }
+    }
+}
+#endif
+
+size_t parser_t::get_json_blocks(const uint8_t *begin, const uint8_t *end, std::vector<slice_t> &data_blocks) const {
+    size_t size = end - begin;
+
+    if (size < 8) {
         throw std::runtime_error("No data");
     }
 
     // determine number of data blocks
-    uint32_t nr_data_blocks = get_data_block_count(buffer);
+    uint32_t nr_data_blocks = get_data_block_count(begin, end);
     
     // reserve enough place in data_blocks vector
-    data_blocks.reserve(nr_data_blocks);
+    data_blocks.reserve(nr_data_blocks + 1);
     
     // try to create a data block reference for each data block
-    unsigned long data_block_sz_offset = 8;
+    size_t data_block_sz_offset = 8;
     for (uint32_t ix = 0; ix < nr_data_blocks; ++ix) {
         // create data block
-        const uint32_t *block_size = reinterpret_cast<const uint32_t*>(&buffer[data_block_sz_offset]);
+        if (data_block_sz_offset + sizeof(uint32_t) > size) {
+            throw std::runtime_error("Invalid block size.");
+        }
+
+        uint32_t block_size = get_field<uint32_t>(begin, end, data_block_sz_offset);
         size_t data_block_offset = data_block_sz_offset + sizeof(uint32_t);
-        auto data_block_beg = buffer.begin() + data_block_offset;
 
-        if (data_block_offset + *block_size > buffer.size()) {
+        if (data_block_offset + block_size > size) {
             throw std::runtime_error("Invalid block size.");
         }
 
-        auto data_block_end = data_block_beg + *block_size;
-        data_blocks.emplace_back(data_block_beg, data_block_end);
+        data_blocks.emplace_back(begin + data_block_offset, begin + data_block_offset + block_size);
         
         // modify offset for next data block
-        data_block_sz_offset = data_block_offset + *block_size;
+        data_block_sz_offset = data_block_offset + block_size;
     }
+
+    return data_block_sz_offset;
+}
+
+void parser_t::get_data_blocks(const uint8_t *begin, const uint8_t *end, std::vector<slice_t> &data_blocks) const {
+    size_t size = end - begin;
+    size_t data_block_sz_offset = get_json_blocks(begin, end, data_blocks);
     
     // last slice contains encrypted / compressed game replay, seperated by 8 bytes with unknown content
-    // uint32_t decompressed_size = *reinterpret_cast<const uint32_t *>(&buffer[data_block_sz_offset]);
-    uint32_t compressed_size = *reinterpret_cast<const uint32_t *>(&buffer[data_block_sz_offset + 4]);
+    if (data_block_sz_offset + 8 > size) {
+        throw std::runtime_error("Invalid block size.");
+    }
+
+    // uint32_t decompressed_size = get_field<uint32_t>(begin, end, data_block_sz_offset);
+    uint32_t compressed_size = get_field<uint32_t>(begin, end, data_block_sz_offset + 4);
 
     auto start = data_block_sz_offset;
-    auto end = start + 8 + ((compressed_size + 7) / 8)*8;
-    data_blocks.emplace_back(buffer.begin() + start, buffer.begin() + end);
-}
+    auto stop = start + 8 + ((static_cast<size_t>(compressed_size) + 7) / 8)*8;
 
-void parser_t::read_packets(game_t &game) {
-    packet_reader->init(game.version, &game.replay, game.title);
-    while (packet_reader->has_next()) {
-        game.packets.reserve(500000);
-        game.packets.push_back(packet_reader->next());
+    if (stop > size) {
+        throw std::runtime_error("Invalid block size.");
     }
 
-#ifndef _DEBUG
-    game.packets.shrink_to_fit();
-#endif
+    data_blocks.emplace_back(begin + start, begin + stop);
 }
 
 void parser_t::read_arena_info(game_t& game) {
-    // get game details
-    Json::Value root;
-    Json::Reader reader;
-    std::string doc(game.game_begin.begin(), game.game_begin.end());
-    reader.parse(doc, root);
-
-    if (root.isMember("gameplayType")) {
-        game.game_mode = root["gameplayType"].asString();
-    } else if (root.isMember("gameplayID")) {
+    // get game details, only the members used here are read from the document
+    json_scanner_t scanner(game.game_begin.begin(), game.game_begin.end());
+    std::string key, value, map_name, gameplay_type, gameplay_id, client_version;
+    bool has_gameplay_type = false, has_gameplay_id = false, has_client_version = false;
+
+    if (scanner.begin_object()) {
+        while (scanner.next_key(key)) {
+            if (key == "gameplayType") {
+                has_gameplay_type = scanner.read_string(gameplay_type);
+            } else if (key == "gameplayID") {
+                has_gameplay_id = scanner.read_string(gameplay_id);
+            } else if (key == "mapName") {
+                scanner.read_string(map_name);
+            } else if (key == "clientVersionFromExe") {
+                has_client_version = scanner.read_string(client_version);
+            } else {
+                scanner.skip_value();
+            }
+        }
+    }
+
+    if (has_gameplay_type) {
+        game.game_mode = gameplay_type;
+    } else if (has_gameplay_id) {
         // from 8.0 this is renamed
-        game.game_mode = root["gameplayID"].asString();
+        game.game_mode = gameplay_id;
     }
 
-	std::string map_name = root["mapName"].asString();
+    // version as reported by the client, replaced by the version string of the replay data block when it is parsed
+    if (has_client_version) {
+        game.version = version_t(client_version);
+    }
 
 	// explicit check for game version should be better
-	get_arena(map_name, game.arena, load_data_mode == load_data_mode_t::on_demand);
+	game.arena = get_arena(map_name, load_data_mode == load_data_mode_t::on_demand);
+}
+
+/**
+ * Enter the object at the position of the scanner and move to the value of a member.
+ * @return \c true if the member was found
+ */
+static bool find_member(json_scanner_t &scanner, const std::string &name) {
+    std::string key;
+    if (!scanner.begin_object()) {
+        return false;
+    }
+
+    while (scanner.next_key(key)) {
+        if (key == name) {
+            return true;
+        }
+        scanner.skip_value();
+    }
+
+    return false;
 }
 
 void parser_t::read_player_info(game_t& game) {
-    // get game details
-    Json::Value root;
-    Json::Reader reader;
-    std::string doc(game.player_info.begin(), game.player_info.end());
-    reader.parse(doc, root);
+    // get game details, the document is an array of the results ([0]) and the vehicles ([1])
+    json_scanner_t scanner(game.player_info.begin(), game.player_info.end());
+    std::string key;
+    const uint8_t *personal = nullptr, *account_players = nullptr;
+    std::vector<std::pair<std::string, player_t>> vehicles;
+
+    if (scanner.begin_array()) {
+        // the members of the results are read once the vehicles are scanned
+        if (scanner.next_element() && scanner.begin_object()) {
+            while (scanner.next_key(key)) {
+                if (key == "personal") {
+                    personal = scanner.tell();
+                } else if (key == "players") {
+                    account_players = scanner.tell();
+                }
+                scanner.skip_value();
+            }
+        }
 
-	auto player_account_id = root[0]["personal"]["avatar"]["accountDBID"].asString();
-    auto player_name = root[0]["players"][player_account_id]["name"].asString();
+        if (scanner.next_element() && scanner.begin_object()) {
+            while (scanner.next_key(key)) {
+                player_t player = {};
+                if (scanner.begin_object()) {
+                    std::string member;
+                    while (scanner.next_key(member)) {
+                        if (member == "name") {
+                            scanner.read_string(player.name);
+                        } else if (member == "team") {
+                            scanner.read_int(player.team);
+                        } else if (member == "vehicleType") {
+                            scanner.read_string(player.tank);
+                        } else {
+                            scanner.skip_value();
+                        }
+                    }
+                }
+                vehicles.emplace_back(key, std::move(player));
+            }
+        }
+    }
 
-    auto vehicles = root[1];
+    std::string player_account_id, player_name;
+    if (personal != nullptr) {
+        scanner.seek(personal);
+        if (find_member(scanner, "avatar") && find_member(scanner, "accountDBID")) {
+            scanner.read_string(player_account_id);
+        }
+    }
+
+    if (account_players != nullptr) {
+        scanner.seek(account_players);
+        if (find_member(scanner, player_account_id) && find_member(scanner, "name")) {
+            scanner.read_string(player_name);
+        }
+    }
 
 	// if (vehicles.isArray()) {
 	// 	// world of warships
@@ -348,23 +1064,29 @@ void parser_t::read_player_info(game_t& game) {
 	// 	game.title = game_title_t::world_of_warships;
 	// }
 
-    // world of tanks
-    for (auto it = vehicles.begin(); it != vehicles.end(); ++it) {
-        player_t player;
+    // world of tanks, the vehicles are kept in the order of their keys
+    std::sort(vehicles.begin(), vehicles.end(), [](const std::pair<std::string, player_t> &left,
+                                                   const std::pair<std::string, player_t> &right) {
+        return left.first < right.first;
+    });
+
+    std::vector<player_t> players;
+    players.reserve(vehicles.size());
+    for (auto &vehicle : vehicles) {
+        player_t &player = vehicle.second;
 
-        player.player_id = boost::lexical_cast<int>(it.key().asString());
-        player.name = (*it)["name"].asString();
-        player.team = (*it)["team"].asInt();
-        player.tank = (*it)["vehicleType"].asString();
+        player.player_id = boost::lexical_cast<int>(vehicle.first);
         player.tank = player.tank.substr(player.tank.find(':') + 1);
 
         if (player.name == player_name) {
             game.recorder_id = player.player_id;
         }
 
-        game.players[player.player_id] = player;
         game.teams[player.team - 1].insert(player.player_id);
-    }	
+        players.push_back(std::move(player));
+    }
+
+    game.player_table.assign(std::move(players), game.recorder_id);
 
     game.title = game_title_t::world_of_tanks;
 }
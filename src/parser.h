@@ -2,14 +2,18 @@
 #define wotreplay_parser_h
 
 #include <boost/filesystem.hpp>
+#include <functional>
 #include <iostream>
+#include <memory>
 #include <set>
 #include <vector>
 
 #include "arena.h"
+#include "cipher_context.h"
 #include "game.h"
 #include "packet.h"
 #include "packet_reader.h"
+#include "replay_index.h"
 #include "types.h"
 
 /** @file */
@@ -25,6 +29,44 @@ namespace wotreplay {
         bulk
     };
     
+    /**
+     * @enum wotreplay::decryption_mode_t
+     * @brief Implementations available for decrypting the replay data block
+     */
+    enum class decryption_mode_t {
+        /** decrypt and chain each block in sequence */
+        reference,
+        /** decrypt all blocks at once, then chain them with a (multi-threaded) prefix xor */
+        prefix_xor,
+        /**
+         * decrypt in chunks on a separate thread while the preceding chunks are inflated and framed, reduces
+         * the latency of parsing a single replay. Other uses of the decrypted data block use prefix_xor.
+         */
+        pipelined
+    };
+
+    /**
+     * @enum wotreplay::inflate_backend_t
+     * @brief Implementations available for decompressing the replay data block
+     */
+    enum class inflate_backend_t {
+        /** zlib */
+        zlib,
+        /** libdeflate, only available when built with ENABLE_LIBDEFLATE */
+        libdeflate
+    };
+
+    /**
+     * Callback receiving the packets of a replay which is parsed in streaming mode. The packet
+     * refers to a temporary buffer and is only valid during the call.
+     */
+    typedef std::function<void(const game_t &game, const packet_t &packet)> packet_callback_t;
+
+    /** handles a framed packet, returns \c false to stop framing */
+    typedef std::function<bool(const packet_t &packet)> packet_handler_t;
+
+    class replay_stream_t;
+
     /** wotreplay::parser_t is a class responsible for parsing a World of Tanks replay file.  */
     class parser_t {
         /**
@@ -56,6 +98,77 @@ namespace wotreplay {
          * @return The debug setting for this parser instance.
          */
         bool get_debug() const;
+        /**
+         * Select the implementation used to decrypt the replay data block.
+         * @param decryption_mode The new decryption mode.
+         */
+        void set_decryption_mode(decryption_mode_t decryption_mode);
+        /**
+         * @return The decryption mode for this parser instance.
+         */
+        decryption_mode_t get_decryption_mode() const;
+        /**
+         * Set the maximum number of threads used by decryption_mode_t::prefix_xor. Use 1 when the parsers
+         * already run in parallel, for example in a pipeline.
+         * @param thread_count The maximum number of threads, the number of hardware threads if 0 (default)
+         */
+        void set_thread_count(unsigned thread_count);
+        /**
+         * @return The maximum number of decryption threads for this parser instance.
+         */
+        unsigned get_thread_count() const;
+        /**
+         * Select the cipher implementation used to decrypt the replay data block.
+         * @param cipher_backend The new cipher backend.
+         */
+        void set_cipher_backend(cipher_backend_t cipher_backend);
+        /**
+         * @return The cipher backend for this parser instance.
+         */
+        cipher_backend_t get_cipher_backend() const;
+        /**
+         * Select the implementation used to decompress the replay data block, when the
+         * selected implementation is not available zlib is used.
+         * @param inflate_backend The new inflate backend.
+         */
+        void set_inflate_backend(inflate_backend_t inflate_backend);
+        /**
+         * @return The inflate backend for this parser instance.
+         */
+        inflate_backend_t get_inflate_backend() const;
+        /**
+         * Compact the games after parsing, only the packets of the given types are kept and the raw
+         * data blocks are released, see game_t::compact(). Reduces the memory of games which are kept
+         * after parsing, for example while they wait for a writer in a pipeline.
+         * @param compact \c true to compact the games after parsing
+         * @param types The packet types to keep, all packets if empty
+         */
+        void set_compact(bool compact, std::vector<uint32_t> types = std::vector<uint32_t>());
+        /**
+         * @return The compact setting for this parser instance.
+         */
+        bool get_compact() const;
+        /**
+         * Cache the decoded replays in a directory, see wotreplay::replay_cache_t. A replay file which is
+         * found in the cache is not decrypted and inflated again.
+         * @param cache_directory The cache directory, the cache is disabled if empty (default)
+         */
+        void set_cache_directory(const boost::filesystem::path &cache_directory);
+        /**
+         * @return The cache directory for this parser instance.
+         */
+        const boost::filesystem::path &get_cache_directory() const;
+        /**
+         * Stop parsing at the first packet with a clock past max_clock, the remainder of the replay is not
+         * decrypted and inflated. The game contains the packets up to the limit, a streaming parse passes
+         * only these packets to the callback. Incomplete replays are not written to the cache.
+         * @param max_clock The maximum clock, no limit if infinity (default)
+         */
+        void set_max_clock(float max_clock);
+        /**
+         * @return The maximum clock for this parser instance.
+         */
+        float get_max_clock() const;
         /**
          * Parses the replay file. The inputstream will be consumed completly.
          * @param is The inputstream containing the replay file.
@@ -68,10 +181,98 @@ namespace wotreplay {
          * @param game The output variable containing the parsed contents of the replay file.
          */
         void parse(buffer_t &buffer, wotreplay::game_t &game);
+        /**
+         * Parses the replay file by mapping it into memory. The data blocks 'game begin' and 'game end' are
+         * not copied, the game keeps a reference to the mapping instead. Only the replay data block is copied
+         * to be decrypted.
+         * @param path The path of the replay file.
+         * @param game The output variable containing the parsed contents of the replay file.
+         */
+        void parse(const boost::filesystem::path &path, wotreplay::game_t &game);
+        /**
+         * Parses the replay file in streaming mode. The replay data block is decrypted and inflated
+         * incrementally, each packet is passed to callback as soon as it is complete. The decompressed
+         * replay and the packets are not stored in the game, only the metadata is available after parsing.
+         * @param is The inputstream containing the replay file.
+         * @param game The output variable containing the metadata of the replay file.
+         * @param callback The callback receiving the packets, the metadata of game is available
+         * from the first call.
+         */
+        void parse(std::istream &is, game_t &game, const packet_callback_t &callback);
+        /**
+         * Parses the replay file in streaming mode by mapping it into memory, see
+         * parse(std::istream &, game_t &, const packet_callback_t &).
+         * @param path The path of the replay file.
+         * @param game The output variable containing the metadata of the replay file.
+         * @param callback The callback receiving the packets, the metadata of game is available
+         * from the first call.
+         */
+        void parse(const boost::filesystem::path &path, game_t &game, const packet_callback_t &callback);
+        /**
+         * Builds an index of inflate checkpoints for the replay file, see wotreplay::replay_index_t.
+         * @param path The path of the replay file.
+         * @param index The output variable containing the index.
+         * @param span The distance between the checkpoints in the decompressed replay.
+         */
+        void build_index(const boost::filesystem::path &path, replay_index_t &index,
+                         size_t span = replay_index_t::default_span);
+        /**
+         * Reads the index stored alongside the replay file (the path of the replay file with ".idx"
+         * appended). When it is missing or does not match the replay file, the index is built and stored.
+         * @param path The path of the replay file.
+         * @param index The output variable containing the index.
+         */
+        void load_index(const boost::filesystem::path &path, replay_index_t &index);
+        /**
+         * Parses the packets of the replay file with a clock in [begin_clock, end_clock] in streaming mode,
+         * see parse(std::istream &, game_t &, const packet_callback_t &). The replay is decrypted and inflated
+         * from the last checkpoint of the index before begin_clock, up to the first packet after end_clock.
+         * @param path The path of the replay file.
+         * @param game The output variable containing the metadata of the replay file.
+         * @param index The index of the replay file, see build_index and load_index.
+         * @param begin_clock The start of the time range.
+         * @param end_clock The end of the time range.
+         * @param callback The callback receiving the packets in the time range.
+         */
+        void parse_range(const boost::filesystem::path &path, game_t &game, const replay_index_t &index,
+                         float begin_clock, float end_clock, const packet_callback_t &callback);
+        /**
+         * Reads only the metadata of the replay file: map, game mode, players, teams and the recorder. The
+         * stream is read up to the replay data block, which is not decrypted or inflated. The packets and
+         * the decompressed replay are not available, the version is the version reported by the client.
+         * @param is The inputstream containing the replay file.
+         * @param game The output variable containing the metadata of the replay file.
+         */
+        void peek(std::istream &is, game_t &game);
+        /**
+         * Reads only the metadata of the replay file by mapping it into memory, see
+         * peek(std::istream &, game_t &).
+         * @param path The path of the replay file.
+         * @param game The output variable containing the metadata of the replay file.
+         */
+        void peek(const boost::filesystem::path &path, game_t &game);
         /**
          * Load supporting game data (optional)
          */
         void load_data();
+        /**
+         * Reference implementation of decrypt_replay, decrypting and chaining one block at a time. Only complete
+         * blocks are decrypted, a trailing partial block is left unchanged.
+         * @param begin start of buffer to decrypt
+         * @param end end of buffer to decrypt
+         * @param key The blowfish key used for decryption.
+         */
+        void decrypt_replay_reference(unsigned char* begin, unsigned char* end, const unsigned char* key);
+        /**
+         * Implementation of decrypt_replay exploiting the independence of the decrypted blocks. The plain
+         * text of a block is the xor of all decrypted blocks up to and including itself, so the buffer is
+         * decrypted in bulk and chained afterwards using a prefix xor. Large buffers are split over
+         * multiple threads.
+         * @param begin start of buffer to decrypt
+         * @param end end of buffer to decrypt
+         * @param key The blowfish key used for decryption.
+         */
+        void decrypt_replay_prefix_xor(unsigned char* begin, unsigned char* end, const unsigned char* key);
     private:
         /**
          * Configures parser configuration using the version string.
@@ -79,6 +280,122 @@ namespace wotreplay {
          * @return Returns if the method was able to configure the parser to match the version
          */
         bool setup(const version_t &version);
+        /**
+         * Parses the replay file contained in the memory range [begin, end).
+         * @param begin start of the replay file contents
+         * @param end end of the replay file contents
+         * @param storage owner of the memory range, the game keeps a reference to it
+         * @param writable \c true if the replay data block may be decrypted in place
+         * @param game The output variable containing the parsed contents of the replay file.
+         */
+        void parse(const uint8_t *begin, const uint8_t *end, std::shared_ptr<const void> storage,
+                   bool writable, game_t &game);
+        /**
+         * Parses the replay file contained in the memory range [begin, end) in streaming mode.
+         * @param begin start of the replay file contents
+         * @param end end of the replay file contents
+         * @param storage owner of the memory range, the game keeps a reference to it
+         * @param game The output variable containing the metadata of the replay file.
+         * @param callback The callback receiving the packets.
+         */
+        void parse(const uint8_t *begin, const uint8_t *end, std::shared_ptr<const void> storage,
+                   game_t &game, const packet_callback_t &callback);
+        /**
+         * Reads the metadata of the replay file contained in the memory range [begin, end).
+         * @param begin start of the replay file contents
+         * @param end end of the replay file contents, the replay data block may be missing
+         * @param storage owner of the memory range, the game keeps a reference to it
+         * @param game The output variable containing the metadata of the replay file.
+         */
+        void peek(const uint8_t *begin, const uint8_t *end, std::shared_ptr<const void> storage, game_t &game);
+        /**
+         * Extracts the metadata of the game from the json data blocks.
+         * @param data_blocks the json data blocks, without the replay data block
+         * @param storage owner of the memory referenced by the data blocks, the game keeps a reference to it
+         * @param game The output variable containing the metadata of the replay file.
+         */
+        void read_metadata(const std::vector<slice_t> &data_blocks, std::shared_ptr<const void> storage,
+                           game_t &game);
+        /**
+         * Reads the data blocks of the replay file contained in the memory range [begin, end) and
+         * extracts the metadata of the game from them.
+         * @param begin start of the replay file contents
+         * @param end end of the replay file contents
+         * @param storage owner of the memory range, the game keeps a reference to it
+         * @param game The output variable containing the metadata of the replay file.
+         * @return The encrypted replay data block
+         */
+        slice_t read_data_blocks(const uint8_t *begin, const uint8_t *end, std::shared_ptr<const void> storage,
+                                 game_t &game);
+        /**
+         * Reads the version string from the start of the decompressed replay and configures the parser.
+         * @param begin start of the decompressed replay
+         * @param end end of the (available part of) the decompressed replay
+         * @param game The output variable containing the version
+         */
+        void read_version(const uint8_t *begin, const uint8_t *end, game_t &game);
+        /**
+         * Reads the metadata and the decompressed replay of a replay file from the cache.
+         * @param key The key of the replay file in the cache
+         * @param game The output variable containing the metadata of the replay file.
+         * @param replay Output variable receiving the decompressed replay, valid as long as game is.
+         * @return \c true if the replay file was found in the cache, \c false if not
+         */
+        bool read_cache(const std::string &key, game_t &game, slice_t &replay);
+        /**
+         * Writes the data blocks of the replay file in [begin, end) and the decompressed replay to the cache.
+         * @param key The key of the replay file in the cache
+         * @param begin start of the replay file contents
+         * @param end end of the replay file contents
+         * @param replay The decompressed replay
+         */
+        void write_cache(const std::string &key, const uint8_t *begin, const uint8_t *end, const slice_t &replay);
+        /**
+         * @return \c true if the packet is past the maximum clock, see set_max_clock()
+         */
+        bool is_past_limit(const packet_t &packet) const;
+        /**
+         * Passes a packet to the callback unless it is past the maximum clock
+         * @return \c false if the packet is past the maximum clock, see set_max_clock()
+         */
+        bool limit_packet(const game_t &game, const packet_t &packet, const packet_callback_t &callback) const;
+        /**
+         * Frames the packets of a decompressed replay and passes them to callback.
+         * @param replay The decompressed replay
+         * @param game The output variable containing the version
+         * @param callback The callback receiving the packets
+         * @return \c true if all packets were framed, \c false if parsing stopped at the maximum clock
+         */
+        bool frame_packets(const slice_t &replay, game_t &game, const packet_callback_t &callback);
+        /**
+         * Decrypts and inflates the replay data block incrementally and passes each packet to callback.
+         * @param replay_block The encrypted replay data block
+         * @param game The output variable containing the version
+         * @param callback The callback receiving the packets
+         * @return \c true if all packets were framed, \c false if parsing stopped at the maximum clock
+         */
+        bool stream_packets(const slice_t &replay_block, game_t &game, const packet_callback_t &callback);
+        /**
+         * Frames the packets of a replay stream from a window on the decompressed replay, the window only
+         * grows when a single packet does not fit. All parsing of a replay stream is built on this method.
+         * @param stream The replay stream
+         * @param game The output variable containing the version
+         * @param read_header \c true if the stream starts at the start of the replay, the version is read from
+         * the first packet and the packet reader is initialized; otherwise the caller initializes the packet reader
+         * @param handler The handler receiving the packets, it returns \c false to stop framing
+         * @return \c true if all packets were framed, \c false if the handler stopped the framing
+         */
+        bool frame_stream(replay_stream_t &stream, game_t &game, bool read_header,
+                          const packet_handler_t &handler);
+        /**
+         * Frames the complete packets in a window, the common loop of frame_stream() and frame_packets()
+         * @param begin The start of the window
+         * @param end The end of the window
+         * @param head The offset of the first packet, advanced past each framed packet
+         * @param handler The handler receiving the packets, it returns \c false to stop framing
+         * @return \c false if the handler stopped the framing
+         */
+        bool frame_window(const uint8_t *begin, const uint8_t *end, size_t &head, const packet_handler_t &handler);
         /**
          * Indicates if the passed buffer_t contains a legacy (< 0.7.2) replay file. 
          * @return \c true if file is in a legacy format \c false if the file is in the 'new' format.
@@ -86,16 +403,26 @@ namespace wotreplay {
         bool is_legacy_replay(const buffer_t &buffer) const;
         /**
          * Extracts each data block from the replay file and adds it the the output variable.
-         * @param buffer A buffer_t containing the complete contents of a replay file.
+         * @param begin start of the complete contents of a replay file.
+         * @param end end of the complete contents of a replay file.
          * @param data_blocks output variable to contain a slice_t to each data block.
          */
-        void get_data_blocks(buffer_t &buffer, std::vector<slice_t> &data_blocks) const;
+        void get_data_blocks(const uint8_t *begin, const uint8_t *end, std::vector<slice_t> &data_blocks) const;
+        /**
+         * Extracts each json data block preceding the replay data block and adds it the the output variable.
+         * @param begin start of the complete contents of a replay file.
+         * @param end end of the complete contents of a replay file.
+         * @param data_blocks output variable to contain a slice_t to each data block.
+         * @return The offset of the replay data block.
+         */
+        size_t get_json_blocks(const uint8_t *begin, const uint8_t *end, std::vector<slice_t> &data_blocks) const;
         /**
          * Determines the number of data blcks in the replay file.
-         * @param buffer A buffer_t containing the complete contents of a replay file.
+         * @param begin start of the complete contents of a replay file.
+         * @param end end of the complete contents of a replay file.
          * @return The number of data blocks present in the replay file.
          */
-        uint32_t get_data_block_count(const buffer_t &buffer) const;
+        uint32_t get_data_block_count(const uint8_t *begin, const uint8_t *end) const;
         /**
          * Performs an in place decryption of the replay using the given key. The decryption
          * is a (broken) variant of CBC decryption and is performed as follows:
@@ -109,13 +436,31 @@ namespace wotreplay {
          */
         void decrypt_replay(unsigned char* begin, unsigned char* end, const unsigned char* key);
         /**
-         * This method performs an extraction (using zlib) of the given replay. The resulting
-         * data is copied to a new buffer.
+         * This method performs an extraction of the given replay. The data is decompressed directly
+         * into the output buffer, which should be sized to the expected decompressed size. The buffer is
+         * resized to the actual decompressed size afterwards.
          * @param begin start of buffer to inflate
          * @param end end of buffer to inflate
          * @param replay The output variable that will contain the decompressed replay after the execution of this method.
          */
         void extract_replay(const unsigned char* begin, const unsigned char* end, buffer_t &replay);
+        /**
+         * Implementation of extract_replay using zlib.
+         * @param begin start of buffer to inflate
+         * @param end end of buffer to inflate
+         * @param replay The output variable that will contain the decompressed replay after the execution of this method.
+         */
+        void extract_replay_zlib(const unsigned char* begin, const unsigned char* end, buffer_t &replay);
+#ifdef ENABLE_LIBDEFLATE
+        /**
+         * Implementation of extract_replay using libdeflate.
+         * @param begin start of buffer to inflate
+         * @param end end of buffer to inflate
+         * @param replay The output variable that will contain the decompressed replay after the execution of this method.
+         * @return \c false if the decompressed replay does not fit into replay
+         */
+        bool extract_replay_libdeflate(const unsigned char* begin, const unsigned char* end, buffer_t &replay);
+#endif
         /**
          * Helper method to read a single packet from a begin and end iterator.
          * @param begin iterator to denote the beginning of the packet.
@@ -124,11 +469,6 @@ namespace wotreplay {
          */
         template <typename iterator>
         packet_t read_packet(iterator begin, iterator end);
-        /**
-         * Helper method to read all the packets contained in the buffer replay_file::replay.
-         * @param game Output variable game
-         */
-        void read_packets(game_t &game);
         /**
          * Extracts a game_info object from either the 'game begin' data block or parsed directly from the 'replay'
          * data block.
@@ -146,6 +486,22 @@ namespace wotreplay {
         std::unique_ptr<packet_reader_t> packet_reader;
         /** Load data mode */
         load_data_mode_t load_data_mode;
+        /** Decryption mode */
+        decryption_mode_t decryption_mode;
+        /** Maximum number of decryption threads, 0 for the number of hardware threads */
+        unsigned thread_count;
+        /** Cipher backend */
+        cipher_backend_t cipher_backend;
+        /** Inflate backend */
+        inflate_backend_t inflate_backend;
+        /** Compact the games after parsing */
+        bool compact;
+        /** Packet types kept when compacting */
+        std::vector<uint32_t> compact_types;
+        /** Directory of the replay cache, empty if disabled */
+        boost::filesystem::path cache_directory;
+        /** Maximum clock of the parsed packets */
+        float max_clock;
     };
 
     template <typename iterator>
@@ -0,0 +1,67 @@
+#include "player_table.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace wotreplay;
+
+/** maximum difference between the lowest and highest player id for direct indexing */
+const uint32_t max_player_id_range = 4096;
+
+const player_table_t::entry_t player_table_t::empty_entry = { -1, -1, false };
+
+void player_table_t::assign(std::vector<player_t> players, uint32_t recorder_id) {
+    clear();
+
+    this->players = std::move(players);
+    if (this->players.empty()) {
+        return;
+    }
+
+    auto cmp_by_id = [](const player_t &left, const player_t &right) {
+        return left.player_id < right.player_id;
+    };
+    auto range = std::minmax_element(this->players.begin(), this->players.end(), cmp_by_id);
+    uint32_t min_id = range.first->player_id, max_id = range.second->player_id;
+    bool dense = max_id - min_id < max_player_id_range;
+
+    if (dense) {
+        first_id = min_id;
+        entries.assign(max_id - min_id + 1, empty_entry);
+    }
+
+    for (size_t ix = 0; ix < this->players.size() && ix <= std::numeric_limits<int16_t>::max(); ++ix) {
+        const player_t &player = this->players[ix];
+
+        entry_t entry;
+        entry.player_ix = static_cast<int16_t>(ix);
+        entry.team_id = (player.team == 1 || player.team == 2) ? static_cast<int8_t>(player.team - 1) : -1;
+        entry.is_recorder = player.player_id == recorder_id;
+
+        if (dense) {
+            entries[player.player_id - first_id] = entry;
+        } else {
+            sparse_entries.emplace_back(player.player_id, entry);
+        }
+    }
+
+    std::sort(sparse_entries.begin(), sparse_entries.end(), [](const std::pair<uint32_t, entry_t> &left,
+                                                               const std::pair<uint32_t, entry_t> &right) {
+        return left.first < right.first;
+    });
+}
+
+void player_table_t::clear() {
+    players.clear();
+    entries.clear();
+    sparse_entries.clear();
+    first_id = 0;
+}
+
+const player_table_t::entry_t &player_table_t::find_sparse(uint32_t player_id) const {
+    auto it = std::lower_bound(sparse_entries.begin(), sparse_entries.end(), player_id,
+                               [](const std::pair<uint32_t, entry_t> &entry, uint32_t player_id) {
+        return entry.first < player_id;
+    });
+    return (it != sparse_entries.end() && it->first == player_id) ? it->second : empty_entry;
+}
@@ -0,0 +1,117 @@
+#ifndef wotreplay_player_table_h
+#define wotreplay_player_table_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+/** @file */
+
+namespace wotreplay {
+    /**
+     * Player information
+     */
+    struct player_t {
+        uint32_t player_id;
+        int team;
+        std::string name;
+        std::string tank;
+    };
+
+    /**
+     * wotreplay::player_table_t maps the player ids of a replay to the player information. The player
+     * ids of a battle are close to each other, the table is indexed directly by the offset of the player
+     * id to the lowest player id.
+     */
+    class player_table_t {
+    public:
+        /**
+         * Replace the content of the table.
+         * @param players The players of the replay
+         * @param recorder_id The player id of the recorder of the replay
+         */
+        void assign(std::vector<player_t> players, uint32_t recorder_id);
+        /**
+         * Removes all players from the table.
+         */
+        void clear();
+        /** @return The number of players in the table. */
+        size_t size() const;
+        /**
+         * @param player_id The player id
+         * @return The index of the player in the table, -1 if the player is not in the table.
+         */
+        int find(uint32_t player_id) const;
+        /**
+         * @param player_id The player id
+         * @return The team of the player (0 or 1), -1 if the player is not in a team.
+         */
+        int get_team_id(uint32_t player_id) const;
+        /**
+         * @param player_id The player id
+         * @return \c true if the player recorded the replay
+         */
+        bool is_recorder(uint32_t player_id) const;
+        /**
+         * @param ix The index of the player in the table.
+         * @return The player information
+         */
+        const player_t &get_player(size_t ix) const;
+    private:
+        /** lookup information of a player id */
+        struct entry_t {
+            int16_t player_ix;
+            int8_t team_id;
+            bool is_recorder;
+        };
+        /** @return The entry of a player id, empty_entry if the player is not in the table */
+        const entry_t &get_entry(uint32_t player_id) const;
+        /** @return The entry of a player id from sparse_entries */
+        const entry_t &find_sparse(uint32_t player_id) const;
+        /** entry of the player ids which are not in the table */
+        static const entry_t empty_entry;
+        std::vector<player_t> players;
+        /** entries indexed by player id - first_id */
+        std::vector<entry_t> entries;
+        uint32_t first_id = 0;
+        /** entries sorted by player id, used instead of entries when the player ids are too far apart */
+        std::vector<std::pair<uint32_t, entry_t>> sparse_entries;
+    };
+
+    inline size_t player_table_t::size() const {
+        return players.size();
+    }
+
+    inline int player_table_t::find(uint32_t player_id) const {
+        return get_entry(player_id).player_ix;
+    }
+
+    inline int player_table_t::get_team_id(uint32_t player_id) const {
+        return get_entry(player_id).team_id;
+    }
+
+    inline bool player_table_t::is_recorder(uint32_t player_id) const {
+        return get_entry(player_id).is_recorder;
+    }
+
+    inline const player_t &player_table_t::get_player(size_t ix) const {
+        return players[ix];
+    }
+
+    inline const player_table_t::entry_t &player_table_t::get_entry(uint32_t player_id) const {
+        uint32_t slot = player_id - first_id;
+        if (slot < entries.size()) {
+            return entries[slot];
+        }
+
+        if (!sparse_entries.empty()) {
+            return find_sparse(player_id);
+        }
+
+        return empty_entry;
+    }
+}
+
+#endif /* defined(wotreplay_player_table_h) */
@@ -0,0 +1,144 @@
+#include "logger.h"
+#include "packet.h"
+#include "replay_cache.h"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <cstring>
+#include <fstream>
+
+#include <openssl/evp.h>
+
+using namespace wotreplay;
+
+static const char cache_magic[] = "WOTRC001";
+static const size_t cache_magic_size = sizeof(cache_magic) - 1;
+
+replay_cache_t::replay_cache_t(const boost::filesystem::path &directory)
+    : directory(directory)
+{}
+
+std::string replay_cache_t::get_key(const uint8_t *begin, const uint8_t *end) {
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digest_size = 0;
+    if (EVP_Digest(begin, end - begin, digest, &digest_size, EVP_sha1(), nullptr) != 1) {
+        throw std::runtime_error("Failed to determine the hash of the replay file.");
+    }
+
+    static const char hex[] = "0123456789abcdef";
+    std::string key;
+    for (unsigned int ix = 0; ix < digest_size; ++ix) {
+        key += hex[digest[ix] >> 4];
+        key += hex[digest[ix] & 0xF];
+    }
+    return key;
+}
+
+boost::filesystem::path replay_cache_t::get_path(const std::string &key) const {
+    return directory / (key + ".wotrc");
+}
+
+/**
+ * Read a block prefixed by its size (uint32_t) at offset.
+ * @return \c false if the block is outside of [begin, end)
+ */
+static bool read_block(const uint8_t *begin, const uint8_t *end, size_t &offset, slice_t &block) {
+    if (offset + sizeof(uint32_t) > static_cast<size_t>(end - begin)) {
+        return false;
+    }
+
+    uint32_t size = get_field<uint32_t>(begin, end, offset);
+    offset += sizeof(uint32_t);
+    if (offset + size > static_cast<size_t>(end - begin)) {
+        return false;
+    }
+
+    block = slice_t(begin + offset, begin + offset + size);
+    offset += size;
+    return true;
+}
+
+bool replay_cache_t::read(const std::string &key, std::shared_ptr<const void> &storage,
+                          std::vector<slice_t> &data_blocks, slice_t &replay) const {
+    boost::filesystem::path path = get_path(key);
+    boost::system::error_code ec;
+    uintmax_t size = boost::filesystem::file_size(path, ec);
+    if (ec || size < cache_magic_size + sizeof(uint32_t)) {
+        return false;
+    }
+
+    std::shared_ptr<boost::interprocess::mapped_region> region;
+    try {
+        boost::interprocess::file_mapping mapping(path.string().c_str(), boost::interprocess::read_only);
+        region = std::make_shared<boost::interprocess::mapped_region>(mapping, boost::interprocess::read_only);
+    }
+    catch (std::exception &e) {
+        logger.writef(log_level_t::warning, "Failed to read cache entry (%1%): %2%\n", path.string(), e.what());
+        return false;
+    }
+
+    const uint8_t *begin = static_cast<const uint8_t*>(region->get_address());
+    const uint8_t *end = begin + region->get_size();
+    if (std::memcmp(begin, cache_magic, cache_magic_size) != 0) {
+        logger.writef(log_level_t::warning, "Invalid cache entry: %1%\n", path.string());
+        return false;
+    }
+
+    size_t offset = cache_magic_size;
+    uint32_t nr_data_blocks = get_field<uint32_t>(begin, end, offset);
+    offset += sizeof(uint32_t);
+
+    std::vector<slice_t> blocks(nr_data_blocks);
+    slice_t replay_block;
+    bool valid = nr_data_blocks > 0;
+    for (uint32_t ix = 0; valid && ix < nr_data_blocks; ++ix) {
+        valid = read_block(begin, end, offset, blocks[ix]);
+    }
+
+    if (!valid || !read_block(begin, end, offset, replay_block) || offset != size) {
+        logger.writef(log_level_t::warning, "Invalid cache entry: %1%\n", path.string());
+        return false;
+    }
+
+    storage = region;
+    data_blocks.swap(blocks);
+    replay = replay_block;
+    return true;
+}
+
+/** Write the size (uint32_t) and the contents of a block */
+static void write_block(std::ostream &os, const slice_t &block) {
+    uint32_t size = static_cast<uint32_t>(block.size());
+    os.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    os.write(reinterpret_cast<const char*>(block.begin()), block.size());
+}
+
+void replay_cache_t::write(const std::string &key, const std::vector<slice_t> &data_blocks, const slice_t &replay) const {
+    boost::system::error_code ec;
+    boost::filesystem::create_directories(directory, ec);
+    boost::filesystem::path temp_path = directory / boost::filesystem::unique_path(key + "-%%%%%%%%.tmp", ec);
+
+    {
+        std::ofstream os(temp_path.string(), std::ios::binary);
+        os.write(cache_magic, cache_magic_size);
+        uint32_t nr_data_blocks = static_cast<uint32_t>(data_blocks.size());
+        os.write(reinterpret_cast<const char*>(&nr_data_blocks), sizeof(nr_data_blocks));
+        for (const slice_t &data_block : data_blocks) {
+            write_block(os, data_block);
+        }
+        write_block(os, replay);
+
+        if (!os) {
+            logger.writef(log_level_t::warning, "Failed to write cache entry: %1%\n", temp_path.string());
+            os.close();
+            boost::filesystem::remove(temp_path, ec);
+            return;
+        }
+    }
+
+    boost::filesystem::rename(temp_path, get_path(key), ec);
+    if (ec) {
+        logger.writef(log_level_t::warning, "Failed to write cache entry (%1%): %2%\n", get_path(key).string(), ec.message());
+        boost::filesystem::remove(temp_path, ec);
+    }
+}
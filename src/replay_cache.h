@@ -0,0 +1,63 @@
+#ifndef wotreplay_replay_cache_h
+#define wotreplay_replay_cache_h
+
+#include "types.h"
+
+#include <boost/filesystem.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+/** @file */
+
+namespace wotreplay {
+    /**
+     * wotreplay::replay_cache_t stores decoded replays in a directory, so a replay which is parsed again does
+     * not have to be decrypted and inflated. An entry is keyed by the SHA-1 hash of the replay file and contains
+     * the json data blocks and the decompressed replay, in a layout which is used directly from a mapping:
+     *
+     * - magic "WOTRC001" (8 bytes)
+     * - number of data blocks (uint32_t), followed by the size (uint32_t) and contents of each data block
+     * - size of the decompressed replay (uint32_t), followed by the decompressed replay
+     */
+    class replay_cache_t {
+    public:
+        /**
+         * Create a cache storing its entries in a directory, the directory is created by the first write.
+         * @param directory The cache directory.
+         */
+        explicit replay_cache_t(const boost::filesystem::path &directory);
+        /**
+         * Determine the key of a replay file.
+         * @param begin start of the replay file contents
+         * @param end end of the replay file contents
+         * @return The SHA-1 hash of the replay file, as hexadecimal string
+         */
+        static std::string get_key(const uint8_t *begin, const uint8_t *end);
+        /**
+         * Read an entry by mapping it into memory, an entry which is missing or invalid is not read.
+         * @param key The key of the replay file
+         * @param storage Output variable receiving the owner of the mapping
+         * @param data_blocks Output variable receiving the json data blocks
+         * @param replay Output variable receiving the decompressed replay
+         * @return \c true if the entry was read, \c false if not
+         */
+        bool read(const std::string &key, std::shared_ptr<const void> &storage,
+                  std::vector<slice_t> &data_blocks, slice_t &replay) const;
+        /**
+         * Write an entry, the entry is written to a temporary file which is renamed once it is complete
+         * so concurrent readers never see a partial entry. Failing to write the entry is not an error.
+         * @param key The key of the replay file
+         * @param data_blocks The json data blocks
+         * @param replay The decompressed replay
+         */
+        void write(const std::string &key, const std::vector<slice_t> &data_blocks, const slice_t &replay) const;
+    private:
+        /** @return The path of the entry for key */
+        boost::filesystem::path get_path(const std::string &key) const;
+        /** directory containing the entries */
+        boost::filesystem::path directory;
+    };
+}
+
+#endif /* defined(wotreplay_replay_cache_h) */
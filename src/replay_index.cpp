@@ -0,0 +1,205 @@
+#include "packet.h"
+#include "replay_index.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#include <zlib.h>
+
+using namespace wotreplay;
+
+#ifndef __func__
+#define __func__ __FUNCTION__
+#endif
+
+static const char index_magic[] = "WOTRI001";
+static const size_t index_magic_size = sizeof(index_magic) - 1;
+/** size of the window of deflate */
+static const size_t window_size = 32 * 1024;
+/** packets are prefixed with the size of their payload, see packet_reader_80_t */
+static const size_t base_packet_size = 12;
+
+void replay_index_t::build(const uint8_t *begin, size_t compressed_size, size_t decompressed_size, size_t span) {
+    checkpoints.clear();
+    header.clear();
+    this->compressed_size = static_cast<uint32_t>(compressed_size);
+    this->decompressed_size = static_cast<uint32_t>(decompressed_size);
+
+    buffer_t replay(decompressed_size);
+
+    z_stream strm = {};
+    if (inflateInit(&strm) != Z_OK) {
+        std::stringstream msg;
+        msg << __func__
+            << ": inflateInit() failed!";
+        throw std::runtime_error(msg.str());
+    }
+
+    strm.next_in = const_cast<uint8_t*>(begin);
+    strm.avail_in = static_cast<uInt>(compressed_size);
+    strm.next_out = replay.data();
+    strm.avail_out = static_cast<uInt>(replay.size());
+
+    // stop at each deflate block boundary, a checkpoint can only be created between two blocks
+    int ret;
+    while ((ret = inflate(&strm, Z_BLOCK)) == Z_OK) {
+        bool block_boundary = (strm.data_type & 128) != 0 && (strm.data_type & 64) == 0;
+        if (block_boundary && (checkpoints.empty() || strm.total_out - checkpoints.back().output_offset >= span)) {
+            inflate_checkpoint_t checkpoint;
+            checkpoint.output_offset = static_cast<uint32_t>(strm.total_out);
+            checkpoint.input_offset = static_cast<uint32_t>(strm.total_in);
+            checkpoint.bits = strm.data_type & 7;
+
+            // decryption continues at the block containing the first byte which is not consumed completely
+            size_t block = (checkpoint.input_offset - (checkpoint.bits != 0 ? 1 : 0)) / sizeof(uint64_t);
+            checkpoint.carry = 0;
+            if (block > 0) {
+                std::memcpy(&checkpoint.carry, begin + (block - 1) * sizeof(uint64_t), sizeof(uint64_t));
+            }
+
+            size_t window_begin = checkpoint.output_offset - std::min<size_t>(checkpoint.output_offset, window_size);
+            checkpoint.window.assign(replay.begin() + window_begin, replay.begin() + checkpoint.output_offset);
+            checkpoints.push_back(std::move(checkpoint));
+        }
+    }
+
+    (void)inflateEnd(&strm);
+
+    if (ret != Z_STREAM_END) {
+        std::stringstream msg;
+        msg << __func__
+            << ": inflate() failed!";
+        throw std::runtime_error(msg.str());
+    }
+
+    // map the checkpoints to the first packet following them
+    auto checkpoint = checkpoints.begin();
+    float clock = 0.f;
+    size_t pos = 0;
+    while (pos + base_packet_size <= replay.size()) {
+        size_t packet_size = get_field<uint32_t>(replay.begin(), replay.end(), pos) + base_packet_size;
+        if (pos + packet_size > replay.size()) {
+            break;
+        }
+
+        packet_t packet(slice_t(replay.data() + pos, replay.data() + pos + packet_size));
+        if (packet.has_property(property_t::clock)) {
+            clock = packet.clock();
+        }
+
+        if (pos == 0) {
+            header.assign(replay.begin(), replay.begin() + packet_size);
+        }
+
+        for (; checkpoint != checkpoints.end() && checkpoint->output_offset <= pos; ++checkpoint) {
+            checkpoint->packet_offset = static_cast<uint32_t>(pos);
+            checkpoint->clock = clock;
+        }
+
+        pos += packet_size;
+    }
+
+    for (; checkpoint != checkpoints.end(); ++checkpoint) {
+        checkpoint->packet_offset = static_cast<uint32_t>(pos);
+        checkpoint->clock = clock;
+    }
+}
+
+const inflate_checkpoint_t &replay_index_t::find(float clock) const {
+    auto it = std::lower_bound(checkpoints.begin(), checkpoints.end(), clock,
+                               [](const inflate_checkpoint_t &checkpoint, float clock) {
+                                   return checkpoint.clock < clock;
+                               });
+    return it == checkpoints.begin() ? *it : *(it - 1);
+}
+
+bool replay_index_t::empty() const {
+    return checkpoints.empty();
+}
+
+const std::vector<inflate_checkpoint_t> &replay_index_t::get_checkpoints() const {
+    return checkpoints;
+}
+
+const buffer_t &replay_index_t::get_header() const {
+    return header;
+}
+
+bool replay_index_t::matches(size_t compressed_size, size_t decompressed_size) const {
+    return !checkpoints.empty() && this->compressed_size == compressed_size &&
+        this->decompressed_size == decompressed_size;
+}
+
+template <typename T>
+static void write_value(std::ostream &os, const T &value) {
+    os.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+static bool read_value(std::istream &is, T &value) {
+    return static_cast<bool>(is.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+static void write_buffer(std::ostream &os, const buffer_t &buffer) {
+    write_value(os, static_cast<uint32_t>(buffer.size()));
+    os.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+}
+
+static bool read_buffer(std::istream &is, buffer_t &buffer, size_t max_size) {
+    uint32_t size;
+    if (!read_value(is, size) || size > max_size) {
+        return false;
+    }
+
+    buffer.resize(size);
+    return static_cast<bool>(is.read(reinterpret_cast<char*>(buffer.data()), size));
+}
+
+void replay_index_t::write(std::ostream &os) const {
+    os.write(index_magic, index_magic_size);
+    write_value(os, compressed_size);
+    write_value(os, decompressed_size);
+    write_buffer(os, header);
+    write_value(os, static_cast<uint32_t>(checkpoints.size()));
+    for (const inflate_checkpoint_t &checkpoint : checkpoints) {
+        write_value(os, checkpoint.output_offset);
+        write_value(os, checkpoint.input_offset);
+        write_value(os, checkpoint.bits);
+        write_value(os, checkpoint.carry);
+        write_value(os, checkpoint.packet_offset);
+        write_value(os, checkpoint.clock);
+        write_buffer(os, checkpoint.window);
+    }
+}
+
+bool replay_index_t::read(std::istream &is) {
+    char magic[index_magic_size];
+    if (!is.read(magic, index_magic_size) || std::memcmp(magic, index_magic, index_magic_size) != 0) {
+        return false;
+    }
+
+    uint32_t count;
+    if (!read_value(is, compressed_size) || !read_value(is, decompressed_size) ||
+        !read_buffer(is, header, decompressed_size) || !read_value(is, count)) {
+        return false;
+    }
+
+    checkpoints.clear();
+    for (uint32_t ix = 0; ix < count; ++ix) {
+        inflate_checkpoint_t checkpoint;
+        if (!read_value(is, checkpoint.output_offset) || !read_value(is, checkpoint.input_offset) ||
+            !read_value(is, checkpoint.bits) || !read_value(is, checkpoint.carry) ||
+            !read_value(is, checkpoint.packet_offset) || !read_value(is, checkpoint.clock) ||
+            !read_buffer(is, checkpoint.window, window_size) ||
+            checkpoint.input_offset > compressed_size || checkpoint.packet_offset > decompressed_size ||
+            checkpoint.bits > 7) {
+            checkpoints.clear();
+            return false;
+        }
+        checkpoints.push_back(std::move(checkpoint));
+    }
+
+    return !checkpoints.empty();
+}
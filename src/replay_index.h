@@ -0,0 +1,89 @@
+#ifndef wotreplay_replay_index_h
+#define wotreplay_replay_index_h
+
+#include "types.h"
+
+#include <iostream>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/** @file */
+
+namespace wotreplay {
+    /**
+     * A point in the compressed replay data block at which decryption and decompression can be resumed,
+     * in the style of the zran example of zlib.
+     */
+    struct inflate_checkpoint_t {
+        /** offset in the decompressed replay */
+        uint32_t output_offset;
+        /** offset in the compressed data of the first byte which is not completely consumed */
+        uint32_t input_offset;
+        /** number of bits of the byte preceding input_offset which are not consumed, 0 - 7 */
+        uint8_t bits;
+        /** decrypted 8 byte block preceding the block which contains the first byte to consume */
+        uint64_t carry;
+        /** offset in the decompressed replay of the first packet starting at or after output_offset */
+        uint32_t packet_offset;
+        /** clock of the packet at packet_offset, or of the last packet with a clock before it */
+        float clock;
+        /** decompressed data preceding output_offset, up to 32K */
+        buffer_t window;
+    };
+
+    /**
+     * wotreplay::replay_index_t contains inflate checkpoints at regular distances in the decompressed
+     * replay, mapped to the clock of the packets. It allows to decode the packets of a time range
+     * without decrypting and inflating the replay from its start, see parser_t::parse_range.
+     */
+    class replay_index_t {
+    public:
+        /** default distance between the checkpoints in the decompressed replay */
+        static const size_t default_span = 1024 * 1024;
+        /**
+         * Build the index from the decrypted replay data block.
+         * @param begin start of the decrypted data, directly following the size fields
+         * @param compressed_size size of the compressed data
+         * @param decompressed_size size of the decompressed replay
+         * @param span distance between the checkpoints in the decompressed replay
+         */
+        void build(const uint8_t *begin, size_t compressed_size, size_t decompressed_size,
+                   size_t span = default_span);
+        /**
+         * Find the checkpoint from which to decode the packets with a clock of at least clock.
+         * @param clock The start of the time range
+         * @return The last checkpoint before clock, or the first checkpoint
+         */
+        const inflate_checkpoint_t &find(float clock) const;
+        /** @return \c true if the index does not contain checkpoints */
+        bool empty() const;
+        /** @return The checkpoints, ordered by output_offset */
+        const std::vector<inflate_checkpoint_t> &get_checkpoints() const;
+        /** @return The first packet of the decompressed replay, it contains the version of the replay */
+        const buffer_t &get_header() const;
+        /**
+         * @return \c true if the index was built for a replay data block with these sizes
+         */
+        bool matches(size_t compressed_size, size_t decompressed_size) const;
+        /**
+         * Write the index to a stream.
+         * @param os The output stream
+         */
+        void write(std::ostream &os) const;
+        /**
+         * Read an index written by write().
+         * @param is The input stream
+         * @return \c true if a valid index was read, \c false if not
+         */
+        bool read(std::istream &is);
+    private:
+        std::vector<inflate_checkpoint_t> checkpoints;
+        /** first packet of the decompressed replay */
+        buffer_t header;
+        uint32_t compressed_size = 0;
+        uint32_t decompressed_size = 0;
+    };
+}
+
+#endif /* defined(wotreplay_replay_index_h) */
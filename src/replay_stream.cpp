@@ -0,0 +1,200 @@
+#include "replay_stream.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+using namespace wotreplay;
+
+#ifndef __func__
+#define __func__ __FUNCTION__
+#endif
+
+uint64_t wotreplay::prefix_xor(unsigned char *begin, unsigned char *end, uint64_t carry) {
+    for (unsigned char *p = begin; p < end; p += sizeof(carry)) {
+        uint64_t block;
+        std::memcpy(&block, p, sizeof(block));
+        carry ^= block;
+        std::memcpy(p, &carry, sizeof(carry));
+    }
+    return carry;
+}
+
+static const int key_size = 16;
+static const unsigned char iv[key_size] = {0};
+
+replay_stream_t::replay_stream_t(const uint8_t *begin, const uint8_t *end, size_t compressed_size,
+                                 const unsigned char *key, cipher_backend_t cipher_backend, bool pipelined)
+    : pos(begin), end(end), remaining(std::min<size_t>(compressed_size, end - begin)),
+      cipher_context("BF-ECB", key, key_size, iv, cipher_backend), carry(0), strm(), stream_end(false),
+      current(nullptr)
+{
+    // small enough to stay in cache, large enough to amortize the calls to the cipher
+    const size_t chunk_size = 64 * 1024;
+    chunk.resize(chunk_size);
+
+    if (inflateInit(&strm) != Z_OK) {
+        std::stringstream msg;
+        msg << __func__
+            << ": inflateInit() failed!";
+        throw std::runtime_error(msg.str());
+    }
+
+    if (pipelined) {
+        // larger chunks than in sequential mode, to limit the hand-overs between the threads
+        const size_t ring_capacity = 8;
+        const size_t ring_chunk_size = 256 * 1024;
+        ring.reset(new chunk_ring_t(ring_capacity, ring_chunk_size));
+        decryptor = std::thread(&replay_stream_t::decrypt_ahead, this);
+    }
+}
+
+replay_stream_t::replay_stream_t(const uint8_t *begin, const uint8_t *end, size_t compressed_size,
+                                 const unsigned char *key, cipher_backend_t cipher_backend,
+                                 const inflate_checkpoint_t &checkpoint)
+    : pos(begin), end(end), remaining(std::min<size_t>(compressed_size, end - begin)),
+      cipher_context("BF-ECB", key, key_size, iv, cipher_backend), carry(checkpoint.carry), strm(), stream_end(false),
+      current(nullptr)
+{
+    const size_t chunk_size = 64 * 1024;
+    chunk.resize(chunk_size);
+
+    // the checkpoint is in the middle of the deflate stream, continue without the zlib header
+    if (inflateInit2(&strm, -15) != Z_OK) {
+        std::stringstream msg;
+        msg << __func__
+            << ": inflateInit2() failed!";
+        throw std::runtime_error(msg.str());
+    }
+
+    // decryption continues at the block containing the first byte which is not consumed completely
+    size_t first = checkpoint.input_offset - (checkpoint.bits != 0 ? 1 : 0);
+    size_t skip = first % sizeof(carry);
+    pos += first - skip;
+    remaining -= std::min(remaining, first - skip);
+
+    if (!decrypt_chunk() || strm.avail_in <= skip) {
+        (void)inflateEnd(&strm);
+        throw std::runtime_error("Invalid checkpoint.");
+    }
+
+    strm.next_in += skip;
+    strm.avail_in -= static_cast<uInt>(skip);
+
+    if (checkpoint.bits != 0) {
+        int value = *strm.next_in;
+        strm.next_in += 1;
+        strm.avail_in -= 1;
+        (void)inflatePrime(&strm, checkpoint.bits, value >> (8 - checkpoint.bits));
+    }
+
+    if (!checkpoint.window.empty()) {
+        (void)inflateSetDictionary(&strm, checkpoint.window.data(), static_cast<uInt>(checkpoint.window.size()));
+    }
+}
+
+replay_stream_t::~replay_stream_t() {
+    if (ring) {
+        // stop the decryption thread when the stream is not read completely
+        ring->close();
+        decryptor.join();
+    }
+
+    (void)inflateEnd(&strm);
+}
+
+void replay_stream_t::decrypt_ahead() {
+    try {
+        chunk_t *chunk;
+        while (pos < end && (chunk = ring->acquire_write()) != nullptr) {
+            size_t size = std::min<size_t>(chunk->data.size(), end - pos);
+
+            int decrypted_len;
+            cipher_context.update(chunk->data.data(), &decrypted_len, pos, static_cast<int>(size));
+            carry = prefix_xor(chunk->data.data(), chunk->data.data() + size, carry);
+            pos += size;
+
+            chunk->size = size;
+            ring->commit_write();
+        }
+    }
+    catch (...) {
+        decrypt_error = std::current_exception();
+    }
+
+    ring->close();
+}
+
+bool replay_stream_t::next_chunk() {
+    if (current != nullptr) {
+        ring->commit_read();
+    }
+
+    current = ring->acquire_read();
+    if (current == nullptr) {
+        if (decrypt_error) {
+            std::rethrow_exception(decrypt_error);
+        }
+        return false;
+    }
+
+    size_t compressed = std::min(current->size, remaining);
+    remaining -= compressed;
+    strm.next_in = current->data.data();
+    strm.avail_in = static_cast<uInt>(compressed);
+    return compressed > 0;
+}
+
+bool replay_stream_t::decrypt_chunk() {
+    if (ring) {
+        return next_chunk();
+    }
+
+    size_t size = std::min<size_t>(chunk.size(), end - pos);
+    if (size == 0) {
+        return false;
+    }
+
+    int decrypted_len;
+    cipher_context.update(chunk.data(), &decrypted_len, pos, static_cast<int>(size));
+    carry = prefix_xor(chunk.data(), chunk.data() + size, carry);
+    pos += size;
+
+    // the data block is padded to the block size, the padding is not passed to zlib
+    size_t compressed = std::min(size, remaining);
+    remaining -= compressed;
+    strm.next_in = chunk.data();
+    strm.avail_in = static_cast<uInt>(compressed);
+    return compressed > 0;
+}
+
+size_t replay_stream_t::read(uint8_t *out, size_t size) {
+    strm.next_out = out;
+    strm.avail_out = static_cast<uInt>(size);
+
+    while (strm.avail_out > 0 && !stream_end) {
+        if (strm.avail_in == 0 && !decrypt_chunk()) {
+            std::stringstream msg;
+            msg << __func__
+                << ": unexpected end of the replay data block!\n";
+            throw std::runtime_error(msg.str());
+        }
+
+        int ret = inflate(&strm, Z_NO_FLUSH);
+        if (ret == Z_STREAM_END) {
+            stream_end = true;
+        } else if (ret != Z_OK) {
+            std::stringstream msg;
+            msg << __func__
+                << ": infate() failed!\n";
+            throw std::runtime_error(msg.str());
+        }
+    }
+
+    return size - strm.avail_out;
+}
+
+bool replay_stream_t::eof() const {
+    return stream_end;
+}
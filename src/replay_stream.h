@@ -0,0 +1,116 @@
+#ifndef wotreplay_replay_stream_h
+#define wotreplay_replay_stream_h
+
+#include "chunk_ring.h"
+#include "cipher_context.h"
+#include "replay_index.h"
+#include "types.h"
+
+#include <exception>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <thread>
+#include <zlib.h>
+
+/** @file */
+
+namespace wotreplay {
+    /**
+     * Chain the decrypted 8 byte blocks in [begin, end), each block is xor'ed with all the blocks before it.
+     * @param begin start of the decrypted blocks
+     * @param end end of the decrypted blocks
+     * @param carry the xor of all the blocks preceding begin
+     * @return the xor of carry and all the blocks in [begin, end)
+     */
+    uint64_t prefix_xor(unsigned char *begin, unsigned char *end, uint64_t carry);
+
+    /**
+     * wotreplay::replay_stream_t incrementally decrypts and inflates the replay data block. Only a small
+     * chunk of the data block is decrypted at a time, so the decompressed replay never has to be held
+     * in memory completely. In pipelined mode a separate thread decrypts ahead of the inflation, the decrypted
+     * chunks are passed through a wotreplay::chunk_ring_t.
+     */
+    class replay_stream_t {
+    public:
+        /**
+         * Create a stream reading the encrypted replay data block.
+         * @param begin start of the encrypted data, directly following the size fields
+         * @param end end of the encrypted data, the length of [begin, end) is a multiple of 8
+         * @param compressed_size the size of the compressed data in [begin, end), without padding
+         * @param key The blowfish key used for decryption.
+         * @param cipher_backend The cipher implementation used for decryption.
+         * @param pipelined \c true to decrypt on a separate thread
+         */
+        replay_stream_t(const uint8_t *begin, const uint8_t *end, size_t compressed_size,
+                        const unsigned char *key, cipher_backend_t cipher_backend, bool pipelined = false);
+        /**
+         * Create a stream reading the encrypted replay data block from a checkpoint, the first byte read is
+         * the byte at checkpoint.output_offset of the decompressed replay.
+         * @param begin start of the encrypted data, directly following the size fields
+         * @param end end of the encrypted data, the length of [begin, end) is a multiple of 8
+         * @param compressed_size the size of the compressed data in [begin, end), without padding
+         * @param key The blowfish key used for decryption.
+         * @param cipher_backend The cipher implementation used for decryption.
+         * @param checkpoint The checkpoint from which decryption and decompression continues.
+         */
+        replay_stream_t(const uint8_t *begin, const uint8_t *end, size_t compressed_size,
+                        const unsigned char *key, cipher_backend_t cipher_backend,
+                        const inflate_checkpoint_t &checkpoint);
+        replay_stream_t(const replay_stream_t&) = delete;
+        replay_stream_t &operator=(const replay_stream_t&) = delete;
+        ~replay_stream_t();
+        /**
+         * Read the next part of the decompressed replay.
+         * @param out output buffer
+         * @param size size of the output buffer
+         * @return The number of bytes read, this is less than size only at the end of the stream.
+         */
+        size_t read(uint8_t *out, size_t size);
+        /**
+         * @return \c true if the complete replay has been read, \c false if not
+         */
+        bool eof() const;
+    private:
+        /**
+         * Decrypt the next chunk of the data block and pass it to zlib.
+         * @return \c false if there is no encrypted data left
+         */
+        bool decrypt_chunk();
+        /**
+         * Pass the next chunk decrypted by the decryption thread to zlib, in pipelined mode.
+         * @return \c false if there is no encrypted data left
+         */
+        bool next_chunk();
+        /**
+         * Decrypt the data block into the chunks of the ring, runs on the decryption thread.
+         */
+        void decrypt_ahead();
+        /** start of the encrypted data which is not decrypted yet */
+        const uint8_t *pos;
+        /** end of the encrypted data */
+        const uint8_t *end;
+        /** number of compressed bytes which are not passed to zlib yet */
+        size_t remaining;
+        /** cipher used to decrypt the blocks */
+        CipherContext cipher_context;
+        /** xor of all the decrypted blocks so far */
+        uint64_t carry;
+        /** the decrypted chunk */
+        buffer_t chunk;
+        /** zlib state */
+        z_stream strm;
+        /** indicates the end of the compressed stream is reached */
+        bool stream_end;
+        /** chunks decrypted ahead, in pipelined mode */
+        std::unique_ptr<chunk_ring_t> ring;
+        /** chunk of the ring passed to zlib, in pipelined mode */
+        chunk_t *current;
+        /** decryption thread, in pipelined mode */
+        std::thread decryptor;
+        /** error raised by the decryption thread */
+        std::exception_ptr decrypt_error;
+    };
+}
+
+#endif /* defined(wotreplay_replay_stream_h) */
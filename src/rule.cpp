@@ -343,7 +343,7 @@ std::string virtual_machine_t::operator()(std::string str) {
 }
 
 static const tank_t get_tank(const game_t &game, const packet_t &p) {
-    const player_t player = game.get_player(p.player_id());
+    const player_t &player = game.get_player(p.player_id());
     const auto &tanks = get_tanks();
     return tanks.count(player.tank) ? tanks.at(player.tank) : tank_t {};
 }
@@ -430,3 +430,276 @@ std::string virtual_machine_t::operator()(operation_t operation) {
     return result ? "true" : "false";
 }
 
+
+/** convert a string to a number like boost::lexical_cast, @return \c false if it is not a number */
+template <typename T>
+static bool to_number(const std::string &str, T &number) {
+    try {
+        number = boost::lexical_cast<T>(str);
+        return true;
+    } catch (boost::bad_lexical_cast &) {
+        return false;
+    }
+}
+
+/**
+ * @return \c true if evaluating the operand may throw, an ordering throws if an operand is not a number
+ */
+static bool may_throw(const operand_t &operand) {
+    const operation_t *operation = boost::get<operation_t>(&operand);
+    if (operation == nullptr) {
+        return false;
+    }
+
+    switch(operation->op) {
+        case operator_t::EQUAL:
+        case operator_t::NOT_EQUAL:
+        case operator_t::AND:
+        case operator_t::OR:
+            return may_throw(operation->left) || may_throw(operation->right);
+        default:
+            return true;
+    }
+}
+
+rule_program_t::rule_program_t()
+    : game(nullptr)
+{
+    empty_row.fill(intern(""));
+    compiled_size = strings.values.size();
+}
+
+rule_program_t::rule_program_t(const std::vector<draw_rule_t> &rules)
+    : rule_program_t()
+{
+    for (const draw_rule_t &rule : rules) {
+        conditions.push_back(compile(rule.expr));
+    }
+    compiled_size = strings.values.size();
+}
+
+int rule_program_t::intern(const std::string &str) {
+    auto it = strings.ids.find(str);
+    if (it != strings.ids.end()) {
+        return it->second;
+    }
+
+    value_t value;
+    value.str = str;
+    value.number = 0.;
+    value.is_number = to_number(str, value.number);
+
+    int id = static_cast<int>(strings.values.size());
+    strings.values.push_back(std::move(value));
+    strings.ids[str] = id;
+    return id;
+}
+
+void rule_program_t::bind(const game_t &game) {
+    this->game = &game;
+    rows.clear();
+
+    // keep the strings of the rules, the strings of the previous game are no longer used
+    for (size_t id = compiled_size; id < strings.values.size(); ++id) {
+        strings.ids.erase(strings.values[id].str);
+    }
+    strings.values.resize(compiled_size);
+
+    const auto &tanks = get_tanks();
+    for (int team_id = 0; team_id < 2; team_id += 1) {
+        for (int player_id : game.get_team(team_id)) {
+            const player_t &player = game.get_player(player_id);
+            auto tank = tanks.find(player.tank);
+            const tank_t &definition = tank != tanks.end() ? tank->second : tank_t {};
+
+            row_t &row = rows[player_id];
+            row[symbol_t::PLAYER] = intern(boost::lexical_cast<std::string>(static_cast<uint32_t>(player_id)));
+            row[symbol_t::CLOCK] = empty_row[symbol_t::CLOCK];
+            row[symbol_t::TEAM] = intern(boost::lexical_cast<std::string>(team_id));
+            row[symbol_t::TANK_ICON] = intern(player.tank);
+            row[symbol_t::TANK_NAME] = intern(definition.name);
+            row[symbol_t::TANK_TIER] = intern(boost::lexical_cast<std::string>(definition.tier));
+            row[symbol_t::TANK_CLASS] = intern(definition.class_name);
+            row[symbol_t::TANK_COUNTRY] = intern(definition.country_name);
+        }
+    }
+}
+
+bool rule_program_t::is_bound(const game_t &game) const {
+    return this->game == &game;
+}
+
+int rule_program_t::operator()(const game_t &game, const packet_t &packet) const {
+    if (game.get_team_id(packet.player_id()) == -1)
+        return -1;
+
+    const row_t *row = &empty_row;
+    if (packet.has_property(property_t::player_id)) {
+        auto it = rows.find(packet.player_id());
+        if (it != rows.end()) {
+            row = &it->second;
+        }
+    }
+
+    context_t context = {strings, *row, packet};
+    for (int i = 0; i < conditions.size(); i += 1) {
+        if (conditions[i](context)) return i;
+    }
+
+    return -1;
+}
+
+rule_program_t::condition_t rule_program_t::compile(const operation_t &operation) {
+    switch(operation.op) {
+        case operator_t::EQUAL:
+            return compile_equality(operation.left, operation.right);
+        case operator_t::NOT_EQUAL: {
+            condition_t equal = compile_equality(operation.left, operation.right);
+            return [equal](const context_t &context) { return !equal(context); };
+        }
+        case operator_t::AND: {
+            condition_t lhs = compile_condition(operation.left);
+            condition_t rhs = compile_condition(operation.right);
+            // virtual_machine_t evaluates both operands, the right operand is evaluated if it may throw
+            if (may_throw(operation.right)) {
+                return [lhs, rhs](const context_t &context) {
+                    bool left = lhs(context);
+                    return rhs(context) && left;
+                };
+            }
+            return [lhs, rhs](const context_t &context) { return lhs(context) && rhs(context); };
+        }
+        case operator_t::OR: {
+            condition_t lhs = compile_condition(operation.left);
+            condition_t rhs = compile_condition(operation.right);
+            if (may_throw(operation.right)) {
+                return [lhs, rhs](const context_t &context) {
+                    bool left = lhs(context);
+                    return rhs(context) || left;
+                };
+            }
+            return [lhs, rhs](const context_t &context) { return lhs(context) || rhs(context); };
+        }
+        default:
+            break;
+    }
+
+    number_t lhs = compile_number(operation.left);
+    number_t rhs = compile_number(operation.right);
+    switch(operation.op) {
+        case operator_t::LESS_THAN:
+            return [lhs, rhs](const context_t &context) { return lhs(context) < rhs(context); };
+        case operator_t::GREATER_THAN:
+            return [lhs, rhs](const context_t &context) { return lhs(context) > rhs(context); };
+        case operator_t::LESS_THAN_OR_EQUAL:
+            return [lhs, rhs](const context_t &context) { return lhs(context) <= rhs(context); };
+        case operator_t::GREATER_THAN_OR_EQUAL:
+            return [lhs, rhs](const context_t &context) { return lhs(context) >= rhs(context); };
+        default:
+            return [](const context_t &context) { return false; };
+    }
+}
+
+rule_program_t::condition_t rule_program_t::compile_condition(const operand_t &operand) {
+    if (const operation_t *operation = boost::get<operation_t>(&operand)) {
+        return compile(*operation);
+    }
+
+    // a value is true if it is the string 'true'
+    text_t text = compile_text(operand);
+    int true_id = intern("true");
+    return [text, true_id](const context_t &context) { return text(context) == true_id; };
+}
+
+rule_program_t::condition_t rule_program_t::compile_equality(const operand_t &left, const operand_t &right) {
+    const symbol_t *left_symbol = boost::get<symbol_t>(&left);
+    const symbol_t *right_symbol = boost::get<symbol_t>(&right);
+    const std::string *left_str = boost::get<std::string>(&left);
+    const std::string *right_str = boost::get<std::string>(&right);
+
+    // compare the clock with a value as a float, equal if the value is the text of that float
+    if ((left_symbol && *left_symbol == symbol_t::CLOCK && right_str) ||
+        (right_symbol && *right_symbol == symbol_t::CLOCK && left_str)) {
+        const std::string &str = left_str ? *left_str : *right_str;
+        float clock;
+        if (!to_number(str, clock) ||
+            boost::lexical_cast<std::string>(clock) != str) {
+            return [](const context_t &context) { return false; };
+        }
+
+        return [clock](const context_t &context) {
+            return context.packet.has_property(property_t::clock) && context.packet.clock() == clock;
+        };
+    }
+
+    text_t lhs = compile_text(left);
+    text_t rhs = compile_text(right);
+    return [lhs, rhs](const context_t &context) { return lhs(context) == rhs(context); };
+}
+
+rule_program_t::text_t rule_program_t::compile_text(const operand_t &operand) {
+    if (const operation_t *operation = boost::get<operation_t>(&operand)) {
+        condition_t condition = compile(*operation);
+        int true_id = intern("true"), false_id = intern("false");
+        return [condition, true_id, false_id](const context_t &context) {
+            return condition(context) ? true_id : false_id;
+        };
+    }
+
+    if (const symbol_t *symbol = boost::get<symbol_t>(&operand)) {
+        if (*symbol != symbol_t::CLOCK) {
+            symbol_t column = *symbol;
+            return [column](const context_t &context) { return context.row[column]; };
+        }
+
+        // the text of a clock is only interned if it occurs in the rules, -1 is not equal to any other value
+        int empty_id = intern("");
+        return [empty_id](const context_t &context) {
+            if (!context.packet.has_property(property_t::clock)) {
+                return empty_id;
+            }
+
+            auto it = context.strings.ids.find(boost::lexical_cast<std::string>(context.packet.clock()));
+            return it != context.strings.ids.end() ? it->second : -1;
+        };
+    }
+
+    const std::string *str = boost::get<std::string>(&operand);
+    int id = intern(str ? *str : "nil");
+    return [id](const context_t &context) { return id; };
+}
+
+rule_program_t::number_t rule_program_t::compile_number(const operand_t &operand) {
+    const symbol_t *symbol = boost::get<symbol_t>(&operand);
+    if (symbol && *symbol == symbol_t::CLOCK) {
+        return [](const context_t &context) -> double {
+            if (!context.packet.has_property(property_t::clock)) {
+                throw boost::bad_lexical_cast(typeid(std::string), typeid(double));
+            }
+            return context.packet.clock();
+        };
+    }
+
+    if (symbol) {
+        symbol_t column = *symbol;
+        return [column](const context_t &context) {
+            const value_t &value = context.strings.values[context.row[column]];
+            if (!value.is_number) {
+                throw boost::bad_lexical_cast(typeid(std::string), typeid(double));
+            }
+            return value.number;
+        };
+    }
+
+    // the result of an operation is 'true' or 'false', which is not a number
+    const std::string *str = boost::get<std::string>(&operand);
+    const value_t &value = strings.values[intern(str ? *str : "nil")];
+    if (!str || !value.is_number) {
+        return [](const context_t &context) -> double {
+            throw boost::bad_lexical_cast(typeid(std::string), typeid(double));
+        };
+    }
+
+    double number = value.number;
+    return [number](const context_t &context) { return number; };
+}
@@ -3,8 +3,12 @@
 
 #include <boost/variant.hpp>
 
+#include <array>
+#include <functional>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 /** @file */
 
@@ -116,4 +120,78 @@ namespace wotreplay {
         const game_t &game;
         packet_t const *p;
     };
+
+    /**
+     * wotreplay::rule_program_t evaluates the drawing rules compiled to typed closures, it replaces
+     * virtual_machine_t when many packets of a game are evaluated. Strings are interned: an equality compares
+     * ids, an ordering compares the numbers parsed when the string was interned. The symbols of the players are
+     * resolved to a row of ids by bind(), only the clock is read from the packets.
+     */
+    class rule_program_t {
+    public:
+        rule_program_t();
+        /**
+         * Compile drawing rules
+         * @param rules rules to compile
+         */
+        explicit rule_program_t(const std::vector<draw_rule_t> &rules);
+        /**
+         * Resolve the symbols of the players of a game, required before evaluating its packets
+         * @param game the game
+         */
+        void bind(const game_t &game);
+        /**
+         * @param game the game
+         * @return \c true if bind() was called for the game
+         */
+        bool is_bound(const game_t &game) const;
+        /**
+         * get the index of the first matching rule, the result is the same as virtual_machine_t, so is the
+         * boost::bad_lexical_cast thrown when an ordering compares a value which is not a number
+         * @param game the game bound by bind()
+         * @param packet packet to evaluate against the rules
+         */
+        int operator()(const game_t &game, const packet_t &packet) const;
+    private:
+        /** interned ids of the values of the symbols, indexed by symbol_t */
+        typedef std::array<int, TANK_COUNTRY + 1> row_t;
+        /** interned string */
+        struct value_t {
+            std::string str;
+            /** the string converted to a number, valid if is_number is set */
+            double number;
+            bool is_number;
+        };
+        /** interned strings */
+        struct string_table_t {
+            /** strings indexed by id */
+            std::vector<value_t> values;
+            std::unordered_map<std::string, int> ids;
+        };
+        /** packet being evaluated */
+        struct context_t {
+            const string_table_t &strings;
+            const row_t &row;
+            const packet_t &packet;
+        };
+        typedef std::function<bool(const context_t&)> condition_t;
+        typedef std::function<int(const context_t&)> text_t;
+        typedef std::function<double(const context_t&)> number_t;
+        /** @return the id of a string, added if it is not interned yet */
+        int intern(const std::string &str);
+        condition_t compile(const operation_t &operation);
+        condition_t compile_condition(const operand_t &operand);
+        condition_t compile_equality(const operand_t &left, const operand_t &right);
+        text_t compile_text(const operand_t &operand);
+        number_t compile_number(const operand_t &operand);
+        string_table_t strings;
+        /** number of strings interned by the rules */
+        size_t compiled_size;
+        std::vector<condition_t> conditions;
+        /** rows of the players of the bound game */
+        std::unordered_map<uint32_t, row_t> rows;
+        /** row of the packets without a player */
+        row_t empty_row;
+        const game_t *game;
+    };
 }
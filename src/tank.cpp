@@ -1,3 +1,4 @@
+#include "catalog.h"
 #include "logger.h"
 #include "regex.h"
 #include "tank.h"
@@ -6,12 +7,15 @@
 #include "tinyxml2.h"
 
 #include <fstream>
+#include <memory>
+#include <mutex>
 
 using namespace wotreplay;
 using namespace tinyxml2;
 
-static std::map<std::string, tank_t> tanks;
-static bool is_tanks_initialized = false;
+/** the tank definitions, published once by init_tank_definition and never replaced */
+static std::shared_ptr<const std::map<std::string, tank_t>> tanks;
+static std::once_flag tanks_initialized;
 
 static std::string get_tanks_xml_content(const std::string &file_name) {
     std::ifstream is(file_name);
@@ -61,7 +65,7 @@ static tank_t get_tank_definition(XMLElement *node) {
     return tank;
 }
 
-static std::map<std::string, tank_t> get_tank_definitions() {
+std::map<std::string, tank_t> wotreplay::read_tank_definitions() {
 	XMLDocument doc;
 	doc.Parse(get_tanks_xml_content("tanks.xml").c_str());
 
@@ -85,12 +89,19 @@ static std::map<std::string, tank_t> get_tank_definitions() {
 }
 
 void wotreplay::init_tank_definition() {
-    if (!is_tanks_initialized) {
-        tanks = get_tank_definitions();
-        is_tanks_initialized = true;
-    }
+    std::call_once(tanks_initialized, [] {
+        // tanks.xml is only parsed when there is no catalog
+        auto definitions = std::make_shared<std::map<std::string, tank_t>>();
+        if (!read_catalog(catalog_path, nullptr, definitions.get())) {
+            *definitions = read_tank_definitions();
+        }
+
+        std::atomic_store(&tanks, std::shared_ptr<const std::map<std::string, tank_t>>(std::move(definitions)));
+    });
 }
 
 const std::map<std::string, tank_t> &wotreplay::get_tanks() {
-    return tanks;
-}
\ No newline at end of file
+    static const std::map<std::string, tank_t> no_tanks;
+    auto definitions = std::atomic_load(&tanks);
+    return definitions ? *definitions : no_tanks;
+}
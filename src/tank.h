@@ -24,15 +24,22 @@ namespace wotreplay {
     };
 
     /**
-     * Get the complete list of available tanks
+     * Get the complete list of available tanks, empty until init_tank_definition() is called. The
+     * definitions are loaded once, they are safe to read from multiple threads.
      * @return tank definitions
      */
     const std::map<std::string, tank_t> &get_tanks();
 
     /**
-     * Init tank defintion.
+     * Init tank defintion, only the first call loads the definitions.
      */
     void init_tank_definition();
+
+    /**
+     * Read all tank definitions from tanks.xml, without using the catalog
+     * @return tank definitions
+     */
+    std::map<std::string, tank_t> read_tank_definitions();
 }
 
 #endif
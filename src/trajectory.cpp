@@ -0,0 +1,82 @@
+#include "trajectory.h"
+
+#include <algorithm>
+
+using namespace wotreplay;
+
+bool trajectory_t::find(float clock, size_t &ix) const {
+    if (this->clock.empty()) {
+        return false;
+    }
+
+    auto after = std::lower_bound(this->clock.begin(), this->clock.end(), clock);
+
+    if (after == this->clock.end()) {
+        ix = size() - 1;
+    } else if (after == this->clock.begin() || *after == clock) {
+        ix = after - this->clock.begin();
+    } else {
+        auto before = after - 1;
+        ix = ((*after - clock < clock - *before) ? after : before) - this->clock.begin();
+    }
+
+    return true;
+}
+
+void trajectory_table_t::build(const packet_table_t &packet_table, const buffer_t &replay) {
+    clear();
+
+    for (size_t ix = 0; ix < packet_table.size(); ++ix) {
+        if (!packet_table.has_property(ix, property_t::position)) {
+            continue;
+        }
+
+        uint32_t player_id = packet_table.player_id(ix);
+        auto it = player_ix.find(player_id);
+        if (it == player_ix.end()) {
+            it = player_ix.emplace(player_id, trajectories.size()).first;
+            trajectories.emplace_back();
+            trajectories.back().player_id = player_id;
+        }
+
+        trajectory_t &trajectory = trajectories[it->second];
+        packet_t packet = packet_table.packet(ix, replay);
+        auto position = packet.position();
+        trajectory.clock.push_back(packet_table.clock(ix));
+        trajectory.x.push_back(std::get<0>(position));
+        trajectory.y.push_back(std::get<1>(position));
+        trajectory.z.push_back(std::get<2>(position));
+        trajectory.hull_orientation.push_back(packet.hull_orientation());
+        trajectory.packet_ix.push_back(static_cast<uint32_t>(ix));
+    }
+
+    for (trajectory_t &trajectory : trajectories) {
+        trajectory.clock.shrink_to_fit();
+        trajectory.x.shrink_to_fit();
+        trajectory.y.shrink_to_fit();
+        trajectory.z.shrink_to_fit();
+        trajectory.hull_orientation.shrink_to_fit();
+        trajectory.packet_ix.shrink_to_fit();
+    }
+
+    built = true;
+}
+
+void trajectory_table_t::clear() {
+    trajectories.clear();
+    player_ix.clear();
+    built = false;
+}
+
+bool trajectory_table_t::is_built() const {
+    return built;
+}
+
+const std::vector<trajectory_t> &trajectory_table_t::get_trajectories() const {
+    return trajectories;
+}
+
+const trajectory_t *trajectory_table_t::find(uint32_t player_id) const {
+    auto it = player_ix.find(player_id);
+    return it == player_ix.end() ? nullptr : &trajectories[it->second];
+}
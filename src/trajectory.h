@@ -0,0 +1,87 @@
+#ifndef wotreplay_trajectory_h
+#define wotreplay_trajectory_h
+
+#include "packet_table.h"
+#include "types.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+/** @file */
+
+namespace wotreplay {
+    /**
+     * wotreplay::trajectory_t contains the positions of a player, in the order of the position packets
+     * in the replay. The fields are stored in parallel arrays.
+     */
+    struct trajectory_t {
+        /** @return The number of positions */
+        size_t size() const;
+        /** @return Position ix as returned by packet_t::position() */
+        std::tuple<float, float, float> position(size_t ix) const;
+        /**
+         * Find the position closest to a clock. Of the positions with the same clock the first one
+         * is returned, if the positions before and after the clock are at the same distance the position
+         * before the clock is returned. The clocks of a player do not decrease in a replay, the position
+         * is found with a binary search.
+         * @param clock The reference clock
+         * @param ix Output variable containing the index of the position
+         * @return \c true if the trajectory is not empty
+         */
+        bool find(float clock, size_t &ix) const;
+
+        uint32_t player_id;
+        std::vector<float> clock;
+        std::vector<float> x;
+        std::vector<float> y;
+        std::vector<float> z;
+        std::vector<std::tuple<float, float, float>> hull_orientation;
+        /** index of the position packet in the packet table */
+        std::vector<uint32_t> packet_ix;
+    };
+
+    /**
+     * wotreplay::trajectory_table_t contains the trajectories of all players of a replay, created in
+     * one pass over the packet table.
+     */
+    class trajectory_table_t {
+    public:
+        /**
+         * Create the trajectories from the position packets of a packet table, replacing the current content.
+         * @param packet_table The packet table
+         * @param replay The decompressed replay containing the packets of the table
+         */
+        void build(const packet_table_t &packet_table, const buffer_t &replay);
+        /**
+         * Removes all trajectories.
+         */
+        void clear();
+        /** @return \c true if build() was called after the last clear() */
+        bool is_built() const;
+        /** @return The trajectories, in order of the first position of the players */
+        const std::vector<trajectory_t> &get_trajectories() const;
+        /**
+         * @param player_id The player id
+         * @return The trajectory of the player, \c nullptr if the player has no positions
+         */
+        const trajectory_t *find(uint32_t player_id) const;
+    private:
+        std::vector<trajectory_t> trajectories;
+        /** index of the trajectory of each player id */
+        std::unordered_map<uint32_t, size_t> player_ix;
+        bool built = false;
+    };
+
+    inline size_t trajectory_t::size() const {
+        return clock.size();
+    }
+
+    inline std::tuple<float, float, float> trajectory_t::position(size_t ix) const {
+        return std::make_tuple(x[ix], y[ix], z[ix]);
+    }
+}
+
+#endif /* defined(wotreplay_trajectory_h) */
@@ -1,6 +1,11 @@
 #ifndef wotreplay_types_h
 #define wotreplay_types_h
 
+#include <memory>
+#include <new>
+#include <stdint.h>
+#include <type_traits>
+#include <utility>
 #include <vector>
 #include <boost/range/iterator_range.hpp>
 
@@ -8,15 +13,41 @@
 
 namespace wotreplay {
     /**
-     * @typedef typedef std::vector<uint8_t> wot::buffer_t
-     * @brief Definition of buffer_t.
+     * Allocator which default initializes the elements it constructs without arguments, resizing
+     * a container using this allocator leaves new elements of trivial types uninitialized.
      */
-    typedef std::vector<uint8_t> buffer_t;
+    template <typename T, typename A = std::allocator<T>>
+    class default_init_allocator_t : public A {
+        typedef std::allocator_traits<A> traits_t;
+    public:
+        template <typename U>
+        struct rebind {
+            typedef default_init_allocator_t<U, typename traits_t::template rebind_alloc<U>> other;
+        };
+
+        using A::A;
+
+        template <typename U>
+        void construct(U *ptr) {
+            ::new(static_cast<void*>(ptr)) U;
+        }
+
+        template <typename U, typename... Args>
+        void construct(U *ptr, Args&&... args) {
+            traits_t::construct(static_cast<A&>(*this), ptr, std::forward<Args>(args)...);
+        }
+    };
+
+    /**
+     * @typedef typedef std::vector<uint8_t, default_init_allocator_t<uint8_t>> wot::buffer_t
+     * @brief Definition of buffer_t, resizing a buffer_t does not zero the new contents.
+     */
+    typedef std::vector<uint8_t, default_init_allocator_t<uint8_t>> buffer_t;
     /**
-     * @typedef typedef boost::iterator_range<buffer_t::iterator> wot::slice_t
-     * @brief Definition of slice_t.
+     * @typedef typedef boost::iterator_range<const uint8_t*> wot::slice_t
+     * @brief Definition of slice_t, a read-only view into a buffer_t or a mapped file.
      */
-    typedef boost::iterator_range<buffer_t::iterator> slice_t;
+    typedef boost::iterator_range<const uint8_t*> slice_t;
 }
 
 #endif /* defined(wotreplay_types_h) */
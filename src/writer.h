@@ -6,6 +6,8 @@
 
 #include <iosfwd>
 #include <functional>
+#include <stdint.h>
+#include <vector>
 
 namespace wotreplay {
     typedef std::function<bool(const packet_t&)> filter_t;
@@ -43,6 +45,30 @@ namespace wotreplay {
          * @param game The packet containing the information to be processed.
          */
         virtual void update(const game_t &game) = 0;
+        /**
+         * Indicates if the writer is able to process the packets of a game one by one, while the game is
+         * parsed in streaming mode. A streaming writer is updated by calling writer_t::begin(const game_t &game),
+         * writer_t::update(const game_t &game, const packet_t &packet) for each packet and
+         * writer_t::end(const game_t &game) instead of writer_t::update(const game_t &game).
+         * @return \c true if the writer supports streaming, \c false if not
+         */
+        virtual bool is_streaming() const { return false; }
+        /**
+         * Prepares a streaming writer for the packets of a game.
+         * @param game The game, only the metadata of the game is available.
+         */
+        virtual void begin(const game_t &game) {}
+        /**
+         * Updates a streaming writer with a single packet of the game.
+         * @param game The game, only the metadata of the game is available.
+         * @param packet The packet to be processed, only valid during this call.
+         */
+        virtual void update(const game_t &game, const packet_t &packet) {}
+        /**
+         * Signals a streaming writer all the packets of the game are processed.
+         * @param game The game, only the metadata of the game is available.
+         */
+        virtual void end(const game_t &game) {}
         /**
          * Write a game object to an output stream.
          * @param os Outputstream to write the game to.
@@ -57,6 +83,12 @@ namespace wotreplay {
          * @param filter the filter used
          */
         virtual void set_filter(filter_t filter) = 0;
+        /**
+         * The packet types used by the writer, a game can be compacted to these packets before it is
+         * passed to the writer, see parser_t::set_compact.
+         * @return The packet types, empty if the writer uses all packets
+         */
+        virtual std::vector<uint32_t> get_packet_types() const { return std::vector<uint32_t>(); }
         virtual ~writer_t() {};
     };
 
@@ -0,0 +1,94 @@
+#include "blowfish.h"
+#include "cipher_context.h"
+
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace wotreplay;
+
+/** published Blowfish ECB test vector, in hexadecimal */
+struct test_vector_t {
+    const char *key;
+    const char *plain;
+    const char *cipher;
+};
+
+/** test vectors of Eric Young, the last vectors vary the key length */
+static const test_vector_t test_vectors[] = {
+    { "0000000000000000", "0000000000000000", "4EF997456198DD78" },
+    { "FFFFFFFFFFFFFFFF", "FFFFFFFFFFFFFFFF", "51866FD5B85ECB8A" },
+    { "3000000000000000", "1000000000000001", "7D856F9A613063F2" },
+    { "1111111111111111", "1111111111111111", "2466DD878B963C9D" },
+    { "0123456789ABCDEF", "1111111111111111", "61F9C3802281B096" },
+    { "1111111111111111", "0123456789ABCDEF", "7D0CC630AFDA1EC7" },
+    { "FEDCBA9876543210", "0123456789ABCDEF", "0ACEAB0FC6A0A28D" },
+    { "7CA110454A1A6E57", "01A1D6D039776742", "59C68245EB05282B" },
+    { "0131D9619DC1376E", "5CD54CA83DEF57DA", "B1B8CC0B250F09A0" },
+    { "F0", "FEDCBA9876543210", "F9AD597C49DB005E" },
+    { "F0E1D2C3B4A5968778", "FEDCBA9876543210", "15750E7A4F4EC577" },
+    { "F0E1D2C3B4A5968778695A4B3C2D1E0F", "FEDCBA9876543210", "93142887EE3BE15C" },
+    { "F0E1D2C3B4A5968778695A4B3C2D1E0F0011223344556677", "FEDCBA9876543210", "05044B62FA52D080" },
+};
+
+static std::vector<unsigned char> from_hex(const std::string &hex) {
+    std::vector<unsigned char> bytes;
+    for (size_t ix = 0; ix + 1 < hex.size(); ix += 2) {
+        bytes.push_back(static_cast<unsigned char>(std::stoul(hex.substr(ix, 2), nullptr, 16)));
+    }
+    return bytes;
+}
+
+/**
+ * Checks blowfish_t against the published ECB test vectors, and compares the built-in and OpenSSL backends
+ * of CipherContext on random payloads. The payload sizes include block counts which are not a multiple of
+ * the number of interleaved lanes.
+ */
+int main(int argc, const char * argv[]) {
+    int failures = 0;
+
+    for (const test_vector_t &test_vector : test_vectors) {
+        std::vector<unsigned char> key = from_hex(test_vector.key);
+        std::vector<unsigned char> plain = from_hex(test_vector.plain);
+        std::vector<unsigned char> block = from_hex(test_vector.cipher);
+
+        blowfish_t blowfish(key.data(), static_cast<int>(key.size()));
+        blowfish.decrypt_ecb(block.data(), block.data(), block.size());
+        if (block != plain) {
+            std::cerr << "blowfish_t fails the test vector with key " << test_vector.key << std::endl;
+            failures += 1;
+        }
+    }
+
+    const unsigned char key[16] = {
+        0xDE, 0x72, 0xBE, 0xA0, 0xDE, 0x04, 0xBE, 0xB1, 0xDE, 0xFE, 0xBE, 0xEF, 0xDE, 0xAD, 0xBE, 0xEF
+    };
+    const unsigned char iv[16] = {0};
+    const size_t block_counts[] = { 1, 2, 3, 4, 5, 6, 7, 9, 15, 17, 1023, 64 * 1024 + 3 };
+
+    std::mt19937 random(42);
+    for (size_t block_count : block_counts) {
+        std::vector<unsigned char> payload(block_count * blowfish_t::block_size);
+        for (auto &byte : payload) {
+            byte = static_cast<unsigned char>(random());
+        }
+
+        std::vector<unsigned char> expected(payload.size()), actual(payload.size());
+        int expected_len = 0, actual_len = 0;
+
+        CipherContext openssl("BF-ECB", key, sizeof(key), iv, cipher_backend_t::openssl);
+        openssl.update(expected.data(), &expected_len, payload.data(), static_cast<int>(payload.size()));
+
+        CipherContext builtin("BF-ECB", key, sizeof(key), iv, cipher_backend_t::builtin);
+        builtin.update(actual.data(), &actual_len, payload.data(), static_cast<int>(payload.size()));
+
+        if (expected_len != actual_len || expected != actual) {
+            std::cerr << "the built-in backend differs from OpenSSL for " << block_count << " blocks" << std::endl;
+            failures += 1;
+        }
+    }
+
+    return failures == 0 ? 0 : 1;
+}
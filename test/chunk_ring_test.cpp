@@ -0,0 +1,105 @@
+#include "chunk_ring.h"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+using namespace wotreplay;
+
+/**
+ * Fills each chunk with its sequence number, a fast producer passes the chunks to a slow consumer which
+ * checks the order. Returns the number of chunks consumed.
+ */
+static size_t transfer(size_t count, size_t consumer_delay_us, int &failures) {
+    chunk_ring_t ring(4, 64);
+
+    std::thread producer([&] {
+        for (size_t i = 0; i < count; ++i) {
+            chunk_t *chunk = ring.acquire_write();
+            if (chunk == nullptr) {
+                break;
+            }
+            chunk->data[0] = static_cast<uint8_t>(i);
+            chunk->size = 1;
+            ring.commit_write();
+        }
+        ring.close();
+    });
+
+    size_t consumed = 0;
+    while (chunk_t *chunk = ring.acquire_read()) {
+        if (chunk->size != 1 || chunk->data[0] != static_cast<uint8_t>(consumed)) {
+            std::cerr << "chunk " << consumed << " is out of order" << std::endl;
+            failures += 1;
+        }
+        ring.commit_read();
+        consumed += 1;
+
+        std::this_thread::sleep_for(std::chrono::microseconds(consumer_delay_us));
+    }
+
+    producer.join();
+    return consumed;
+}
+
+/**
+ * Tests wotreplay::chunk_ring_t: a fast producer with a slow consumer, closing the ring by the producer
+ * while the consumer waits for a chunk and closing the ring by the consumer while the producer waits for a
+ * free chunk. A lost wake-up shows up as a test which does not finish.
+ */
+int main(int argc, const char * argv[]) {
+    int failures = 0;
+
+    // fast producer, slow consumer, the producer blocks on a full ring
+    size_t consumed = transfer(200, 1000, failures);
+    if (consumed != 200) {
+        std::cerr << "consumed " << consumed << " of 200 chunks" << std::endl;
+        failures += 1;
+    }
+
+    // without delay the threads mostly pass chunks while spinning
+    consumed = transfer(100000, 0, failures);
+    if (consumed != 100000) {
+        std::cerr << "consumed " << consumed << " of 100000 chunks" << std::endl;
+        failures += 1;
+    }
+
+    // the producer closes the ring while the consumer is blocked on an empty ring
+    {
+        chunk_ring_t ring(4, 64);
+        chunk_t *chunk = reinterpret_cast<chunk_t*>(1);
+        std::thread consumer([&] {
+            chunk = ring.acquire_read();
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        ring.close();
+        consumer.join();
+
+        if (chunk != nullptr) {
+            std::cerr << "acquire_read returned a chunk from a closed, empty ring" << std::endl;
+            failures += 1;
+        }
+    }
+
+    // the consumer closes the ring while the producer is blocked on a full ring
+    {
+        chunk_ring_t ring(4, 64);
+        size_t produced = 0;
+        std::thread producer([&] {
+            while (ring.acquire_write() != nullptr) {
+                ring.commit_write();
+                produced += 1;
+            }
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        ring.close();
+        producer.join();
+
+        if (produced != 4) {
+            std::cerr << "produced " << produced << " chunks into a ring of 4 chunks" << std::endl;
+            failures += 1;
+        }
+    }
+
+    return failures == 0 ? 0 : 1;
+}
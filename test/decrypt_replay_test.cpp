@@ -0,0 +1,55 @@
+#include "parser.h"
+
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace wotreplay;
+
+/**
+ * Compares decrypt_replay_reference and decrypt_replay_prefix_xor on random payloads, the outputs must be
+ * byte-identical. The sizes include payloads which are not a multiple of the block size, the prefix xor is
+ * tested with multiple thread counts to split the payloads into chunks. Both cipher backends are tested.
+ */
+int main(int argc, const char * argv[]) {
+    const unsigned char key[16] = {
+        0xDE, 0x72, 0xBE, 0xA0, 0xDE, 0x04, 0xBE, 0xB1, 0xDE, 0xFE, 0xBE, 0xEF, 0xDE, 0xAD, 0xBE, 0xEF
+    };
+    const size_t sizes[] = {
+        8, 13, 16, 1023, 64 * 1024, 1024 * 1024 + 3, 4 * 1024 * 1024, 32 * 1024 * 1024 + 5
+    };
+
+    parser_t parser(load_data_mode_t::manual);
+    std::mt19937 random(42);
+
+    int failures = 0;
+    for (cipher_backend_t cipher_backend : { cipher_backend_t::builtin, cipher_backend_t::openssl }) {
+        parser.set_cipher_backend(cipher_backend);
+        const char *backend_name = cipher_backend == cipher_backend_t::builtin ? "builtin" : "openssl";
+
+        for (size_t size : sizes) {
+            std::vector<unsigned char> payload(size);
+            for (auto &byte : payload) {
+                byte = static_cast<unsigned char>(random());
+            }
+
+            std::vector<unsigned char> expected(payload);
+            parser.decrypt_replay_reference(expected.data(), expected.data() + expected.size(), key);
+
+            for (unsigned thread_count : {1, 2, 3, 8}) {
+                std::vector<unsigned char> actual(payload);
+                parser.set_thread_count(thread_count);
+                parser.decrypt_replay_prefix_xor(actual.data(), actual.data() + actual.size(), key);
+
+                if (expected != actual) {
+                    std::cerr << "decrypt_replay_prefix_xor differs from the reference for " << size << " bytes using "
+                              << thread_count << " threads and the " << backend_name << " backend" << std::endl;
+                    failures += 1;
+                }
+            }
+        }
+    }
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,208 @@
+#include "json_scanner.h"
+#include "parser.h"
+
+#include <json/json.h>
+
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace wotreplay;
+
+static int failures = 0;
+
+static void check(bool condition, const std::string &message) {
+    if (!condition) {
+        std::cerr << message << std::endl;
+        failures += 1;
+    }
+}
+
+/** @return a scanner of the document, which has to outlive the scanner */
+static json_scanner_t scanner_of(const std::string &document) {
+    const uint8_t *begin = reinterpret_cast<const uint8_t*>(document.data());
+    return json_scanner_t(begin, begin + document.size());
+}
+
+/** the strings are decoded like Json::Reader, including the surrogate pairs */
+static void test_escapes() {
+    const char *documents[] = {
+        R"("plain")",
+        R"("a\"b\\c\/d")",
+        R"("\b\f\n\r\t")",
+        R"("J\u00f6rg \u20AC")",
+        R"("\ud83d\ude00 and \uD834\uDD1E")",
+        R"("")"
+    };
+
+    for (const std::string document : documents) {
+        Json::Value root;
+        Json::Reader reader;
+        reader.parse("[" + document + "]", root);
+
+        std::string value;
+        json_scanner_t scanner = scanner_of(document);
+        check(scanner.read_string(value) && !scanner.failed(), "failed to read " + document);
+        check(value == root[0].asString(), "read_string differs from Json::Reader for " + document);
+    }
+}
+
+/** skip_value skips nested objects and arrays, also when strings contain brackets */
+static void test_skip_value() {
+    const std::string document = R"({
+        "skipped": {"a": [1, 2, {"b": "}]", "c": [[], {}]}], "d": "\"{"},
+        "empty": [],
+        "number": -12.5e3,
+        "literal": true,
+        "value": 42
+    })";
+
+    json_scanner_t scanner = scanner_of(document);
+    std::string key;
+    int value = 0;
+    bool found = false;
+    check(scanner.begin_object(), "document is not an object");
+    while (scanner.next_key(key)) {
+        if (key == "value") {
+            found = scanner.read_int(value);
+        } else {
+            scanner.skip_value();
+        }
+    }
+
+    check(found && value == 42, "member after nested values was not read");
+    check(!scanner.failed(), "skipping nested values failed");
+}
+
+/** a malformed document stops the scanner, the following reads fail */
+static void test_malformed() {
+    const char *documents[] = {
+        R"({"a": "unterminated)",
+        R"({"a": {"b": [1, 2})",
+        R"({"a" 1})",
+        R"({"a": "\u12")",
+        R"({"a": 1, )"
+    };
+
+    for (const std::string document : documents) {
+        json_scanner_t scanner = scanner_of(document);
+        std::string key;
+        if (scanner.begin_object()) {
+            while (scanner.next_key(key)) {
+                scanner.skip_value();
+            }
+        }
+
+        std::string value;
+        check(scanner.failed(), "malformed document was accepted: " + document);
+        check(!scanner.read_string(value) && !scanner.begin_object(),
+              "read after a malformed document succeeded: " + document);
+    }
+}
+
+/** read_int truncates fractions and skips the numbers which do not fit in an int */
+static void test_read_int() {
+    const struct {
+        const char *document;
+        bool valid;
+        int value;
+    } cases[] = {
+        { "2147483647", true, 2147483647 },
+        { "-2147483648", true, -2147483647 - 1 },
+        { "2147483648", false, 0 },
+        { "-2147483649", false, 0 },
+        { "99999999999999999999", false, 0 },
+        { "12.75", true, 12 },
+        { "\"12\"", false, 0 }
+    };
+
+    for (const auto &test_case : cases) {
+        std::string document = std::string("[") + test_case.document + ", 7]";
+        json_scanner_t scanner = scanner_of(document);
+        int value = 0, next = 0;
+        check(scanner.begin_array() && scanner.next_element(), "document is not an array");
+        bool valid = scanner.read_int(value);
+        check(valid == test_case.valid && (!valid || value == test_case.value),
+              std::string("read_int is wrong for ") + test_case.document);
+        check(scanner.next_element() && scanner.read_int(next) && next == 7,
+              std::string("read_int does not skip ") + test_case.document);
+    }
+}
+
+/** the players read by the parser are the players read with Json::Reader */
+static void test_player_info() {
+    const std::string game_begin = R"({"mapName": "unknown", "gameplayID": "ctf"})";
+    const std::string player_info = R"([{
+        "common": {"duration": 420, "bonusType": 1, "finishReason": 2},
+        "personal": {"avatar": {"accountDBID": 5001, "credits": [1, {"x": "]"}]}, "12345": {"damageDealt": 10}},
+        "players": {
+            "5000": {"name": "J\u00f6rg", "team": 1},
+            "5001": {"name": "rec\"order", "team": 1},
+            "5002": {"name": "\ud83d\ude00", "team": 2}
+        },
+        "vehicles": {"12": [{"achievements": [[1, 2], []], "kills": 0}]}
+    }, {
+        "12": {"name": "J\u00f6rg", "team": 1, "vehicleType": "germany:PzVI", "isAlive": true, "events": {}},
+        "9": {"vehicleType": "ussr:T-34", "name": "rec\"order", "team": 1, "isTeamKiller": false},
+        "15": {"name": "\ud83d\ude00", "clanAbbrev": "", "team": 2, "vehicleType": "usa:M4"}
+    }])";
+
+    // the header and the data blocks of a replay file, the replay data block is not needed by peek
+    std::string file(8, '\0');
+    uint32_t block_count = 2;
+    std::memcpy(&file[4], &block_count, sizeof(block_count));
+    for (const std::string &block : { game_begin, player_info }) {
+        uint32_t size = static_cast<uint32_t>(block.size());
+        file.append(reinterpret_cast<const char*>(&size), sizeof(size));
+        file.append(block);
+    }
+
+    parser_t parser(load_data_mode_t::manual);
+    game_t game;
+    std::istringstream is(file);
+    parser.peek(is, game);
+
+    Json::Value root;
+    Json::Reader reader;
+    check(reader.parse(player_info, root), "Json::Reader failed to parse the player info");
+
+    std::string account_id = root[0]["personal"]["avatar"]["accountDBID"].asString();
+    std::string recorder_name = root[0]["players"][account_id]["name"].asString();
+
+    const Json::Value &vehicles = root[1];
+    uint32_t recorder_id = 0;
+    for (auto it = vehicles.begin(); it != vehicles.end(); ++it) {
+        int player_id = std::stoi(it.key().asString());
+        std::string tank = (*it)["vehicleType"].asString();
+        tank = tank.substr(tank.find(':') + 1);
+        int team = (*it)["team"].asInt();
+
+        const player_t &player = game.get_player(player_id);
+        check(player.name == (*it)["name"].asString() && player.tank == tank && player.team == team,
+              "player " + it.key().asString() + " differs from Json::Reader");
+        check(game.get_team(team - 1).count(player_id) == 1,
+              "player " + it.key().asString() + " is not in team " + std::to_string(team));
+
+        if ((*it)["name"].asString() == recorder_name) {
+            recorder_id = player_id;
+        }
+    }
+
+    check(recorder_id == 9 && game.get_recorder_id() == recorder_id, "recorder differs from Json::Reader");
+}
+
+/**
+ * Tests wotreplay::json_scanner_t: escape sequences and surrogate pairs, skipping nested values, malformed
+ * documents, the range of read_int and the player information read by the parser compared to Json::Reader.
+ */
+int main(int argc, const char * argv[]) {
+    test_escapes();
+    test_skip_value();
+    test_malformed();
+    test_read_int();
+    test_player_info();
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,145 @@
+#include "parser.h"
+#include "replay_cache.h"
+#include "rule.h"
+
+#include <boost/filesystem.hpp>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace wotreplay;
+
+/** append a packet with the header (length, type, clock) and a payload of size bytes */
+static uint8_t *append_packet(buffer_t &replay, uint32_t type, float clock, size_t size) {
+    size_t offset = replay.size();
+    replay.resize(offset + 12 + size);
+    uint32_t length = static_cast<uint32_t>(size);
+    std::memcpy(&replay[offset], &length, sizeof(length));
+    std::memcpy(&replay[offset + 4], &type, sizeof(type));
+    std::memcpy(&replay[offset + 8], &clock, sizeof(clock));
+    return &replay[offset];
+}
+
+/**
+ * Create a game of two teams of three players, with a position packet of each player every second. The
+ * game is parsed from a replay cache entry, so the replay does not have to be encrypted and compressed.
+ */
+static void create_game(const boost::filesystem::path &directory, game_t &game) {
+    const std::string game_begin = R"({"mapName": "unknown", "gameplayID": "ctf", "playerID": 1})";
+    const std::string player_info = R"([{"personal": {}}, {
+        "101": {"name": "a", "team": 1, "vehicleType": "ussr:T-34"},
+        "102": {"name": "b", "team": 1, "vehicleType": "germany:PzVI"},
+        "103": {"name": "c", "team": 1, "vehicleType": "usa:M4"},
+        "201": {"name": "d", "team": 2, "vehicleType": "ussr:IS"},
+        "202": {"name": "e", "team": 2, "vehicleType": "germany:PzV"},
+        "203": {"name": "f", "team": 2, "vehicleType": "usa:T29"}
+    }])";
+
+    buffer_t replay;
+    const std::string version = "World of Tanks v.0.9.0 #1";
+    uint8_t *packet = append_packet(replay, 0x14, 0.f, 4 + version.size());
+    uint32_t version_size = static_cast<uint32_t>(version.size());
+    std::memcpy(packet + 12, &version_size, sizeof(version_size));
+    std::memcpy(packet + 16, version.data(), version.size());
+
+    const uint32_t player_ids[] = { 101, 102, 103, 201, 202, 203 };
+    for (int second = 0; second < 20; ++second) {
+        for (uint32_t player_id : player_ids) {
+            packet = append_packet(replay, 0x0a, static_cast<float>(second), 48);
+            std::memcpy(packet + 12, &player_id, sizeof(player_id));
+        }
+    }
+    append_packet(replay, 0xFFFFFFFF, 0.f, 0);
+
+    // the replay file is only used for the key of the cache entry
+    boost::filesystem::path path = directory / "game.wotreplay";
+    std::ofstream(path.string(), std::ios::binary) << "synthetic replay";
+    std::ifstream is(path.string(), std::ios::binary);
+    buffer_t file((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+
+    std::vector<slice_t> data_blocks = {
+        slice_t(reinterpret_cast<const uint8_t*>(game_begin.data()),
+                reinterpret_cast<const uint8_t*>(game_begin.data() + game_begin.size())),
+        slice_t(reinterpret_cast<const uint8_t*>(player_info.data()),
+                reinterpret_cast<const uint8_t*>(player_info.data() + player_info.size()))
+    };
+    replay_cache_t cache(directory / "cache");
+    cache.write(replay_cache_t::get_key(file.data(), file.data() + file.size()), data_blocks,
+                slice_t(replay.data(), replay.data() + replay.size()));
+
+    parser_t parser(load_data_mode_t::manual);
+    parser.set_cache_directory(directory / "cache");
+    parser.parse(path, game);
+}
+
+/** @return the index of the matching rule, or "error" if the evaluation throws */
+template <typename Evaluate>
+static std::string evaluate(Evaluate evaluate) {
+    try {
+        return std::to_string(evaluate());
+    } catch (std::exception &) {
+        return "error";
+    }
+}
+
+/**
+ * Compares rule_program_t with virtual_machine_t on the same rules and packets, both the index of the
+ * matching rule and the errors thrown for orderings on values which are not numbers must be the same.
+ */
+int main(int argc, const char * argv[]) {
+    boost::filesystem::path directory = boost::filesystem::temp_directory_path() /
+        boost::filesystem::unique_path("rule_test-%%%%-%%%%");
+    boost::filesystem::create_directories(directory);
+
+    game_t game;
+    create_game(directory, game);
+    boost::filesystem::remove_all(directory);
+
+    const char *expressions[] = {
+        "#ff0000 := team = '0'; #00ff00 := team = '1'",
+        "#ff0000 := player = '102' or player = '201'; #00ff00 := tank_icon = 'PzVI'",
+        "#ff0000 := clock > '10' and team = '1'; #00ff00 := clock <= '5'",
+        "#ff0000 := clock = '3'; #00ff00 := player >= '200'",
+        "#ff0000 := tank_tier < '5' and player != '103'",
+        // orderings on values which are not numbers throw, also after the result is known from the left operand
+        "#ff0000 := team = '0' or tank_name < '5'",
+        "#ff0000 := team = '5' and clock > 'abc'",
+        "#ff0000 := tank_icon > '1' and team = '0'",
+        "#ff0000 := team = '0' and player < '102' or team = '1' and clock >= '15'",
+        "#ff0000 := team = '1' or tank_class > '1' and player = '101'"
+    };
+
+    int failures = 0;
+    size_t packets = 0;
+    for (const char *expression : expressions) {
+        std::vector<draw_rule_t> rules = parse_draw_rules(expression);
+        rule_program_t program(rules);
+        program.bind(game);
+        virtual_machine_t virtual_machine(game, rules);
+
+        for (const packet_t &packet : game.get_packets()) {
+            if (!packet.has_property(property_t::position)) {
+                continue;
+            }
+
+            packets += 1;
+            std::string expected = evaluate([&] { return virtual_machine(packet); });
+            std::string actual = evaluate([&] { return program(game, packet); });
+            if (expected != actual) {
+                std::cerr << "rule_program_t differs from virtual_machine_t for '" << expression << "' and player "
+                          << packet.player_id() << " at " << packet.clock() << ": " << actual << " instead of "
+                          << expected << std::endl;
+                failures += 1;
+            }
+        }
+    }
+
+    if (packets == 0) {
+        std::cerr << "no packets were evaluated" << std::endl;
+        failures += 1;
+    }
+
+    return failures == 0 ? 0 : 1;
+}